@@ -1,5 +1,47 @@
 #include <benchmark/benchmark.h>
 #include <generator.hpp>
+#include <frame_allocator.hpp>
+#include <epoll_executor.hpp>
+#include <read_ahead.hpp>
+#include <parallel.hpp>
+#include <perf_counters.hpp>
+#include <fused.hpp>
+#include <combinators.hpp>
+#include <fiber.hpp>
+#include <merge.hpp>
+#include <latency.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <mapped_records.hpp>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #ifdef _MSC_VER
 #define NOINLINE __declspec(noinline)
@@ -7,6 +49,236 @@
 #define NOINLINE __attribute__((noinline))
 #endif
 
+template <typename T>
+using pooled_simple_generator = simple::generator<T, T, pooled_frame_allocator<>>;
+template <typename T>
+using pooled_recursive_generator = recursive::generator<T, T, pooled_frame_allocator<>>;
+template <typename T>
+using arena_recursive_generator = recursive::generator<T, T, frame_arena_allocator<>>;
+template <typename T>
+using thread_arena_simple_generator = simple::generator<T, T, thread_arena_allocator<>>;
+template <typename T>
+using thread_arena_recursive_generator = recursive::generator<T, T, thread_arena_allocator<>>;
+// Each generator_policy option on its own, then all of them.
+using terminate_policy = generator_policy<exception_policy::terminate>;
+using eager_policy = generator_policy<exception_policy::propagate, start_policy::eager>;
+using address_policy =
+    generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::address>;
+using lean_policy = generator_policy<exception_policy::terminate, start_policy::eager, storage_policy::address>;
+using lean_recursive_policy =
+    generator_policy<exception_policy::terminate, start_policy::lazy, storage_policy::address>;
+template <typename T, typename Policy>
+using policy_simple_generator = simple::generator<T, T, std::allocator<std::byte>, Policy>;
+template <typename T, typename Policy>
+using policy_recursive_generator = recursive::generator<T, T, std::allocator<std::byte>, Policy>;
+using timed_policy =
+    generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::copy, timing_policy::timed>;
+template <typename T>
+using timed_simple_generator = simple::generator<T, T, std::allocator<std::byte>, timed_policy>;
+template <typename T>
+using timed_recursive_generator = recursive::generator<T, T, std::allocator<std::byte>, timed_policy>;
+// What block yields, chunks(), contiguous elements_of() and size hints need.
+using blocks_policy = generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::copy,
+                                       timing_policy::untimed, filter_policy::unfiltered, block_policy::blocks>;
+template <typename T>
+using blocks_simple_generator = simple::generator<T, T, std::allocator<std::byte>, blocks_policy>;
+template <typename T>
+using blocks_recursive_generator = recursive::generator<T, T, std::allocator<std::byte>, blocks_policy>;
+// What parallel_traverse needs.
+using spawnable_policy =
+    generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::copy, timing_policy::untimed,
+                     filter_policy::unfiltered, block_policy::elements, spawn_policy::spawnable>;
+template <typename T>
+using spawnable_recursive_generator = recursive::generator<T, T, std::allocator<std::byte>, spawnable_policy>;
+template <typename T>
+using spawnable_pooled_recursive_generator = recursive::generator<T, T, pooled_frame_allocator<>, spawnable_policy>;
+// What fused adaptors need.
+using filtered_policy = generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::copy,
+                                         timing_policy::untimed, filter_policy::filtered>;
+template <typename T>
+using filtered_simple_generator = simple::generator<T, T, std::allocator<std::byte>, filtered_policy>;
+template <typename T>
+using filtered_recursive_generator = recursive::generator<T, T, std::allocator<std::byte>, filtered_policy>;
+template <typename T>
+using inline_simple_generator = simple::generator<T, T, inline_frame_allocator<>>;
+template <typename T>
+using inline_recursive_generator = recursive::generator<T, T, inline_frame_allocator<>>;
+
+#if defined(GENERATOR_COUNT_FRAMES)
+// Heap allocations made by the calling thread through the global
+// operator new, coroutine frames included. Like the frame counts, only
+// compiled into bench_counted: the replaced operator new would otherwise
+// be timed by every benchmark that allocates.
+struct heap_counts {
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+
+    static heap_counts& local() noexcept {
+        static thread_local heap_counts counts;
+        return counts;
+    }
+};
+
+static void* counted_allocation(void* p, std::size_t size) {
+    if (!p)
+        throw std::bad_alloc();
+    auto& counts = heap_counts::local();
+    ++counts.allocations;
+    counts.bytes += size;
+    return p;
+}
+
+NOINLINE void* operator new(std::size_t size) {
+    return counted_allocation(std::malloc(size ? size : 1), size);
+}
+
+NOINLINE void* operator new(std::size_t size, std::align_val_t align) {
+    const auto a = static_cast<std::size_t>(align);
+    return counted_allocation(std::aligned_alloc(a, (size + a - 1) / a * a), size);
+}
+
+NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+#endif
+
+// Set by --check_elision: benchmarks expecting their frame allocations to
+// be elided fail when they allocate one.
+static bool check_elision = false;
+static std::atomic<bool> elision_failed = false;
+
+// Counts the events selected with --perf_counters, and in bench_counted
+// heap allocations and coroutine frames, from its construction, just
+// before the benchmark loop, to the end of the benchmark. Hardware events
+// are reported per processed item (per iteration when no items are
+// reported), allocations and frames per iteration, along with the
+// distribution of frame sizes as label. With several threads, the
+// throughput of each thread is reported too.
+//
+// Only the calling thread is accounted for: allocations made by helper
+// threads (read_ahead, parallel_traverse workers) do not show up.
+class perf_scope {
+  public:
+    explicit perf_scope(benchmark::State& state)
+        : state_(state)
+#if defined(GENERATOR_COUNT_FRAMES)
+        , heap_(heap_counts::local()), frames_(frame_counts::local())
+#endif
+    {
+        counters_.start();
+    }
+
+    // Checked with --check_elision.
+    void expect_elided_frames() noexcept {
+        expectElided_ = true;
+    }
+
+    ~perf_scope() {
+        counters_.stop();
+        const double iterations = double(state_.iterations());
+        if (iterations == 0)
+            return;
+        const auto items = state_.items_processed();
+        const double per = items != 0 ? double(items) : iterations;
+        for (const auto& [name, count] : counters_.read())
+            state_.counters[name] = benchmark::Counter(count / per, benchmark::Counter::kAvgThreads);
+        // items_per_second is the throughput of all the threads together.
+        if (items != 0 && state_.threads() > 1)
+            state_.counters["items_per_thread"] = benchmark::Counter(
+                double(items), benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+
+#if defined(GENERATOR_COUNT_FRAMES)
+        const auto& heap = heap_counts::local();
+        state_.counters["allocs"] = benchmark::Counter(
+            double(heap.allocations - heap_.allocations) / iterations, benchmark::Counter::kAvgThreads);
+        const auto& frames = frame_counts::local();
+        const auto count = frames.frames - frames_.frames;
+        state_.counters["frames"] = benchmark::Counter(double(count) / iterations, benchmark::Counter::kAvgThreads);
+        if (count != 0) {
+            state_.counters["frame_bytes"] = benchmark::Counter(
+                double(frames.bytes - frames_.bytes) / double(count), benchmark::Counter::kAvgThreads);
+            std::string label = "frames";
+            for (std::size_t i = 0; i < frame_counts::max_sizes; ++i) {
+                if (frames.counts[i] != frames_.counts[i]) {
+                    char entry[64];
+                    std::snprintf(entry, sizeof(entry), " %zuB:%g", frames.sizes[i],
+                                  double(frames.counts[i] - frames_.counts[i]) / iterations);
+                    label += entry;
+                }
+            }
+            if (frames.others != frames_.others) {
+                char entry[64];
+                std::snprintf(entry, sizeof(entry), " other:%g", double(frames.others - frames_.others) / iterations);
+                label += entry;
+            }
+            state_.SetLabel(label);
+        }
+        if (check_elision && expectElided_ && count != 0) {
+            elision_failed = true;
+            state_.SkipWithError("coroutine frame allocation was not elided");
+        }
+#endif
+    }
+
+  private:
+    benchmark::State& state_;
+#if defined(GENERATOR_COUNT_FRAMES)
+    const heap_counts heap_;
+    const frame_counts frames_;
+#endif
+    bool expectElided_ = false;
+    perf::counters counters_;
+};
+
+// Distribution of the resumption times of timed generators during a
+// benchmark, reported as p50_ns, p99_ns, p999_ns and max_ns counters,
+// along with the time stamp cost subtracted from each sample.
+class latency_scope {
+  public:
+    explicit latency_scope(benchmark::State& state) : state_(state), recorder_(histogram_) {
+    }
+
+    ~latency_scope() {
+        if (histogram_.count() == 0)
+            return;
+        state_.counters["p50_ns"] = histogram_.percentile_ns(0.5);
+        state_.counters["p99_ns"] = histogram_.percentile_ns(0.99);
+        state_.counters["p999_ns"] = histogram_.percentile_ns(0.999);
+        state_.counters["max_ns"] = histogram_.max_ns();
+        state_.counters["timer_ns"] = latency_histogram::to_ns(resume_latency_recorder::overhead());
+    }
+
+  private:
+    benchmark::State& state_;
+    latency_histogram histogram_;
+    resume_latency_recorder recorder_;
+};
+
+// Generators whose frame allocation BM_Dummy expects the compiler to
+// elide: Clang does, GCC does not.
+template <typename Generator>
+constexpr bool expect_elision =
+#if defined(__clang__)
+    std::is_same_v<Generator, simple::generator<uint64_t>>;
+#else
+    false;
+#endif
+
+// The benchmarks run by --check_elision.
+static constexpr const char* elision_checks = "^BM_Dummy<";
+
 template <typename Generator>
 static Generator dummy() {
     co_yield 42;
@@ -39,14 +311,47 @@ static Generator fib_no_inline(int max) {
     }
 }
 
+// Same as dummy_no_inline and fib_no_inline, with the frame allocated in a
+// caller-provided frame_buffer.
+template <typename Generator>
+NOINLINE
+static Generator dummy_in_buffer(std::allocator_arg_t, inline_frame_allocator<>) {
+    co_yield 42;
+}
+
+template <typename Generator>
+NOINLINE
+static Generator fib_in_buffer(std::allocator_arg_t, inline_frame_allocator<>, int max) {
+    auto a = 0, b = 1;
+    for (auto n = 0; n < max; n++) {
+        co_yield b;
+        const auto next = a + b;
+        a = b, b = next;
+    }
+}
+
+static recursive::generator<int> range_nested(int size) {
+    std::vector<int> v(size, 42);
+    co_yield elements_of(v);
+}
 
-static recursive::generator<int> range_nested() {
-    std::vector<int> v(1000, 42);
+static blocks_recursive_generator<int> range_contiguous(const std::vector<int>& v) {
     co_yield elements_of(v);
 }
 
-static simple::generator<int> range() {
-    std::vector<int> v(1000, 42);
+template <std::size_t N>
+static blocks_recursive_generator<int> range_contiguous(const std::array<int, N>& a) {
+    co_yield elements_of(a);
+}
+
+// Hides contiguity, so that elements_of goes through the adapter coroutine.
+template <typename Range>
+static blocks_recursive_generator<int> range_adapted(const Range& r) {
+    co_yield elements_of(r | std::views::transform(std::identity{}));
+}
+
+static simple::generator<int> range(int size) {
+    std::vector<int> v(size, 42);
     for(auto && e : v)
     {
       co_yield e;
@@ -54,120 +359,2469 @@ static simple::generator<int> range() {
 }
 
 
-static simple::generator<int> recursive_simple(int n = 10000) {
-    if(n == 0) {
-        std::vector<int> v(1000, 42);
+// Trees of generators: every level but the last one has `fanout` nested
+// generators, and each of the fanout^depth leaves yields `leaf` values.
+// A fanout of 1 makes a linear chain.
+static simple::generator<int> recursive_simple(int depth, int fanout, int leaf) {
+    if(depth == 0) {
+        std::vector<int> v(leaf, 42);
         for(auto && e : v) {
           co_yield e;
         }
         co_return;
     }
-    for(auto && e : recursive_simple(n - 1))
-    {
-      co_yield e;
+    for(int i = 0; i < fanout; ++i) {
+        for(auto && e : recursive_simple(depth - 1, fanout, leaf))
+        {
+          co_yield e;
+        }
     }
 }
 
-static recursive::generator<int> recursive_symmetric(int n = 10000) {
-    if(n == 0) {
-        std::vector<int> v(1000, 42);
+static recursive::generator<int> recursive_symmetric(int depth, int fanout, int leaf) {
+    if(depth == 0) {
+        std::vector<int> v(leaf, 42);
         co_yield elements_of(v);
         co_return;
     }
-    co_yield elements_of(recursive_symmetric(n - 1));
+    for(int i = 0; i < fanout; ++i) {
+        co_yield elements_of(recursive_symmetric(depth - 1, fanout, leaf));
+    }
+}
+
+static std::int64_t tree_elements(int depth, int fanout, int leaf) {
+    std::int64_t n = leaf;
+    for(int i = 0; i < depth; ++i) {
+        n *= fanout;
+    }
+    return n;
+}
+
+// The dummy, fib, range and tree workloads without coroutines, to tell
+// the overhead of the generators from that of the alternatives: as
+// hand-written cursors keeping their state in an object, as visitors
+// taking a template callback or a std::function, and as visitors run on
+// a stackful fiber. Each baseline passes the values to `f`.
+class dummy_cursor {
+  public:
+    bool next() noexcept {
+        return !std::exchange(done_, true);
+    }
+    std::uint64_t value() const noexcept {
+        return 42;
+    }
+
+  private:
+    bool done_ = false;
+};
+
+class fib_cursor {
+  public:
+    explicit fib_cursor(int max) noexcept : max_(max) {
+    }
+    bool next() noexcept {
+        if (n_ == max_)
+            return false;
+        if (n_++ != 0) {
+            const auto next = a_ + b_;
+            a_ = b_, b_ = next;
+        }
+        return true;
+    }
+    std::uint64_t value() const noexcept {
+        return b_;
+    }
+
+  private:
+    std::uint64_t a_ = 0, b_ = 1;
+    int n_ = 0, max_;
+};
+
+class range_cursor {
+  public:
+    explicit range_cursor(int size) : values_(size, 42) {
+    }
+    bool next() noexcept {
+        return index_++ != values_.size();
+    }
+    int value() const noexcept {
+        return values_[index_ - 1];
+    }
+
+  private:
+    std::vector<int> values_;
+    std::size_t index_ = 0;
+};
+
+// Depth-first walk of the tree of recursive_simple, with an explicit
+// stack of the siblings left to visit on each level.
+class tree_cursor {
+  public:
+    tree_cursor(int depth, int fanout, int leaf)
+        : depth_(depth), fanout_(fanout), leaf_(leaf), pending_(depth, fanout - 1), values_(leaf, 42) {
+    }
+    bool next() {
+        while (index_ == values_.size()) {
+            while (!pending_.empty() && pending_.back() == 0)
+                pending_.pop_back();
+            if (pending_.empty())
+                return false;
+            --pending_.back();
+            pending_.resize(depth_, fanout_ - 1);
+            values_.assign(leaf_, 42);
+            index_ = 0;
+        }
+        ++index_;
+        return true;
+    }
+    int value() const noexcept {
+        return values_[index_ - 1];
+    }
+
+  private:
+    std::size_t depth_;
+    int fanout_, leaf_;
+    std::vector<int> pending_;
+    std::vector<int> values_;
+    std::size_t index_ = 0;
+};
+
+template <typename F>
+static void visit_dummy(F&& f) {
+    f(std::uint64_t(42));
+}
+
+template <typename F>
+static void visit_fib(int max, F&& f) {
+    std::uint64_t a = 0, b = 1;
+    for (auto n = 0; n < max; n++) {
+        f(b);
+        const auto next = a + b;
+        a = b, b = next;
+    }
+}
+
+template <typename F>
+static void visit_range(int size, F&& f) {
+    std::vector<int> v(size, 42);
+    for(auto && e : v) {
+        f(e);
+    }
+}
+
+template <typename F>
+static void visit_tree(int depth, int fanout, int leaf, F&& f) {
+    if(depth == 0) {
+        visit_range(leaf, f);
+        return;
+    }
+    for(int i = 0; i < fanout; ++i) {
+        visit_tree(depth - 1, fanout, leaf, f);
+    }
 }
 
+struct cursor_baseline {
+    template <typename F>
+    static void dummy(F&& f) {
+        for (dummy_cursor c; c.next();)
+            f(c.value());
+    }
+    template <typename F>
+    static void fib(int max, F&& f) {
+        for (fib_cursor c(max); c.next();)
+            f(c.value());
+    }
+    template <typename F>
+    static void range(int size, F&& f) {
+        for (range_cursor c(size); c.next();)
+            f(c.value());
+    }
+    template <typename F>
+    static void tree(int depth, int fanout, int leaf, F&& f) {
+        for (tree_cursor c(depth, fanout, leaf); c.next();)
+            f(c.value());
+    }
+};
+
+struct callback_baseline {
+    template <typename F>
+    static void dummy(F&& f) {
+        visit_dummy(f);
+    }
+    template <typename F>
+    static void fib(int max, F&& f) {
+        visit_fib(max, f);
+    }
+    template <typename F>
+    static void range(int size, F&& f) {
+        visit_range(size, f);
+    }
+    template <typename F>
+    static void tree(int depth, int fanout, int leaf, F&& f) {
+        visit_tree(depth, fanout, leaf, f);
+    }
+};
+
+// Not inlined, as when the visitor is behind an interface.
+struct function_baseline {
+    NOINLINE static void dummy(const std::function<void(std::uint64_t)>& f) {
+        visit_dummy(f);
+    }
+    NOINLINE static void fib(int max, const std::function<void(std::uint64_t)>& f) {
+        visit_fib(max, f);
+    }
+    NOINLINE static void range(int size, const std::function<void(int)>& f) {
+        visit_range(size, f);
+    }
+    NOINLINE static void tree(int depth, int fanout, int leaf, const std::function<void(int)>& f) {
+        visit_tree(depth, fanout, leaf, f);
+    }
+};
+
+#if defined(FIBER_GENERATOR_SUPPORTED)
+struct fiber_baseline {
+    template <typename F>
+    static void dummy(F&& f) {
+        fiber_generator<std::uint64_t> g([](auto& yield) { visit_dummy(yield); });
+        for(auto && v : g)
+            f(v);
+    }
+    template <typename F>
+    static void fib(int max, F&& f) {
+        fiber_generator<std::uint64_t> g([max](auto& yield) { visit_fib(max, yield); });
+        for(auto && v : g)
+            f(v);
+    }
+    template <typename F>
+    static void range(int size, F&& f) {
+        fiber_generator<int> g([size](auto& yield) { visit_range(size, yield); });
+        for(auto && v : g)
+            f(v);
+    }
+    template <typename F>
+    static void tree(int depth, int fanout, int leaf, F&& f) {
+        // Generous room for one visit_tree frame per level: untouched pages
+        // of the stack cost nothing, and an overflow hits its guard page.
+        const auto stack = fiber_generator<int>::default_stack_size + std::size_t(depth) * 1024;
+        fiber_generator<int> g([=](auto& yield) { visit_tree(depth, fanout, leaf, yield); }, stack);
+        for(auto && v : g)
+            f(v);
+    }
+};
+#endif
 
+// Same shape as recursive_symmetric, with a configurable leaf that does
+// not go through the elements_of(range) adapter.
 template <typename Generator>
-static void BM_Dummy(benchmark::State& state) {
-  // Perform setup here
-  for (auto _ : state) {
-    for(auto && v : dummy<Generator>()) {
-        benchmark::DoNotOptimize(v);
+static Generator chain(int depth, int leaf) {
+    if(depth == 0) {
+        for(int i = 0; i < leaf; ++i) {
+            co_yield 42;
+        }
+        co_return;
     }
-  }
+    co_yield elements_of(chain<Generator>(depth - 1, leaf));
+}
+
+static arena_recursive_generator<int> chain_arena(std::allocator_arg_t, frame_arena_allocator<> alloc, int depth, int leaf) {
+    if(depth == 0) {
+        for(int i = 0; i < leaf; ++i) {
+            co_yield 42;
+        }
+        co_return;
+    }
+    co_yield elements_of(chain_arena(std::allocator_arg, alloc, depth - 1, leaf));
 }
 
+// Chain of `depth` generators, each yielding its own depth before
+// descending: after k values, k frames are live.
 template <typename Generator>
-static void BM_DummyNoInline(benchmark::State& state) {
-  for (auto _ : state) {
-    for(auto && v : dummy_no_inline<Generator>()) {
-        benchmark::DoNotOptimize(v);
+static Generator spine(int depth) {
+    co_yield depth;
+    if (depth > 1)
+        co_yield elements_of(spine<Generator>(depth - 1));
+}
+
+// Complete binary tree of the given depth, yielding one value per leaf.
+template <typename Generator>
+static Generator tree(int depth) {
+    if(depth == 0) {
+        co_yield 42;
+        co_return;
     }
-  }
+    co_yield elements_of(tree<Generator>(depth - 1));
+    co_yield elements_of(tree<Generator>(depth - 1));
+}
+
+static arena_recursive_generator<int> tree_arena(std::allocator_arg_t, frame_arena_allocator<> alloc, int depth) {
+    if(depth == 0) {
+        co_yield 42;
+        co_return;
+    }
+    co_yield elements_of(tree_arena(std::allocator_arg, alloc, depth - 1));
+    co_yield elements_of(tree_arena(std::allocator_arg, alloc, depth - 1));
 }
 
+// Pseudo-random data, produced one element per suspension...
 template <typename Generator>
-static void BM_Fib(benchmark::State& state) {
-  for (auto _ : state) {
-    for(auto && v : fib<Generator>(10000)) {
-        benchmark::DoNotOptimize(v);
+static Generator random_elements(int n) {
+    std::uint32_t x = 1;
+    for(int i = 0; i < n; ++i) {
+        x = x * 1664525u + 1013904223u;
+        co_yield x;
     }
-  }
 }
 
+// ... or one block per suspension.
 template <typename Generator>
-static void BM_FibNoInline(benchmark::State& state) {
-  for (auto _ : state) {
-    for(auto && v : fib_no_inline<Generator>(10000)) {
-        benchmark::DoNotOptimize(v);
+static Generator random_blocks(int n, int block) {
+    std::vector<std::uint32_t> buffer(block);
+    std::uint32_t x = 1;
+    for(int i = 0; i < n; i += block) {
+        const int count = std::min(block, n - i);
+        for(int j = 0; j < count; ++j) {
+            x = x * 1664525u + 1013904223u;
+            buffer[j] = x;
+        }
+        co_yield std::span<const std::uint32_t>(buffer.data(), count);
     }
-  }
 }
 
-static void BM_Range(benchmark::State& state) {
-  for (auto _ : state) {
-    for(auto && v : range()) {
-        benchmark::DoNotOptimize(v);
+struct sum_workload {
+    std::uint64_t sum = 0;
+
+    void operator()(std::uint32_t v) {
+        sum += v;
     }
-  }
+    void operator()(std::span<const std::uint32_t> block) {
+        for(auto v : block) {
+            sum += v;
+        }
+    }
+    std::uint64_t result() const {
+        return sum;
+    }
+};
+
+struct minmax_workload {
+    std::uint32_t min = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t max = 0;
+
+    void operator()(std::uint32_t v) {
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    void operator()(std::span<const std::uint32_t> block) {
+        for(auto v : block) {
+            min = std::min(min, v);
+            max = std::max(max, v);
+        }
+    }
+    std::uint64_t result() const {
+        return std::uint64_t(max) - min;
+    }
+};
+
+struct histogram_workload {
+    std::array<std::uint32_t, 256> bins{};
+
+    void operator()(std::uint32_t v) {
+        ++bins[v >> 24];
+    }
+    void operator()(std::span<const std::uint32_t> block) {
+        for(auto v : block) {
+            ++bins[v >> 24];
+        }
+    }
+    std::uint64_t result() const {
+        return bins[0];
+    }
+};
+
+// Pipelines of 1, 3 and 6 stages over the integers below n, run as fused
+// adaptors, as std::views and as one coroutine per stage.
+template <typename Generator>
+static Generator iota(std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i)
+        co_yield i;
 }
 
-static void BM_RangeSymmetricTransfer(benchmark::State& state) {
-  // Perform setup here
-  for (auto _ : state) {
-    for(auto && v : range_nested()) {
-        benchmark::DoNotOptimize(v);
+inline constexpr auto scale = [](std::uint64_t x) { return x * 3 + 1; };
+inline constexpr auto halve = [](std::uint64_t x) { return x / 2; };
+inline constexpr auto is_even = [](std::uint64_t x) { return x % 2 == 0; };
+inline constexpr auto not_multiple_of_3 = [](std::uint64_t x) { return x % 3 != 0; };
+
+template <typename Generator, typename F>
+static Generator nested_transform(Generator g, F f) {
+    for (auto&& v : g)
+        co_yield f(v);
+}
+
+template <typename Generator, typename P>
+static Generator nested_filter(Generator g, P pred) {
+    for (auto&& v : g) {
+        if (pred(v))
+            co_yield v;
     }
-  }
 }
 
-static void BM_DeepRecursion(benchmark::State& state) {
-  for (auto _ : state) {
-    for(auto && v : recursive_simple()) {
-        benchmark::DoNotOptimize(v);
+template <typename Generator>
+static Generator nested_take(Generator g, std::size_t count) {
+    if (count == 0)
+        co_return;
+    for (auto&& v : g) {
+        co_yield v;
+        if (--count == 0)
+            break;
     }
-  }
 }
 
-static void BM_DeepSymmetricTransfer(benchmark::State& state) {
-  // Perform setup here
-  for (auto _ : state) {
-    for(auto && v : recursive_symmetric()) {
-        benchmark::DoNotOptimize(v);
+template <int Stages, typename Generator>
+static auto fused_pipeline(Generator g, std::size_t n) {
+    if constexpr (Stages == 1)
+        return std::move(g) | fused::transform(scale);
+    else if constexpr (Stages == 3)
+        return std::move(g) | fused::transform(scale) | fused::filter(is_even) | fused::transform(halve);
+    else
+        return std::move(g) | fused::transform(scale) | fused::filter(is_even) | fused::transform(halve) |
+               fused::filter(not_multiple_of_3) | fused::transform(scale) | fused::take(n / 4);
+}
+
+template <int Stages, typename Generator>
+static auto views_pipeline(Generator g, std::size_t n) {
+    if constexpr (Stages == 1)
+        return std::move(g) | std::views::transform(scale);
+    else if constexpr (Stages == 3)
+        return std::move(g) | std::views::transform(scale) | std::views::filter(is_even) |
+               std::views::transform(halve);
+    else
+        return std::move(g) | std::views::transform(scale) | std::views::filter(is_even) |
+               std::views::transform(halve) | std::views::filter(not_multiple_of_3) |
+               std::views::transform(scale) | std::views::take(n / 4);
+}
+
+template <int Stages, typename Generator>
+static Generator nested_pipeline(Generator g, std::size_t n) {
+    if constexpr (Stages == 1)
+        return nested_transform(std::move(g), scale);
+    else if constexpr (Stages == 3)
+        return nested_transform(nested_filter(nested_transform(std::move(g), scale), is_even), halve);
+    else
+        return nested_take(
+            nested_transform(
+                nested_filter(nested_transform(nested_filter(nested_transform(std::move(g), scale), is_even), halve),
+                              not_multiple_of_3),
+                scale),
+            n / 4);
+}
+
+// The combinators of combinators.hpp, written as coroutines wrapping the
+// generators they combine.
+template <typename Generator>
+static Generator concat_coroutine(Generator a, Generator b) {
+    for (auto&& v : a)
+        co_yield v;
+    for (auto&& v : b)
+        co_yield v;
+}
+
+template <template <typename...> class Generator>
+static Generator<std::tuple<std::uint64_t, std::uint64_t>> zip_coroutine(Generator<std::uint64_t> a,
+                                                                        Generator<std::uint64_t> b) {
+    for (auto ia = a.begin(), ib = b.begin(); ia != a.end() && ib != b.end(); ++ia, ++ib)
+        co_yield std::tuple(*ia, *ib);
+}
+
+template <template <typename...> class Generator>
+static Generator<std::tuple<std::size_t, std::uint64_t>> enumerate_coroutine(Generator<std::uint64_t> g) {
+    std::size_t i = 0;
+    for (auto&& v : g)
+        co_yield std::tuple(i++, v);
+}
+
+// Without a view reading from the generator, a chunk has to be copied.
+template <template <typename...> class Generator>
+static Generator<std::span<const std::uint64_t>> chunk_coroutine(Generator<std::uint64_t> g, std::size_t size) {
+    std::vector<std::uint64_t> chunk;
+    chunk.reserve(size);
+    for (auto&& v : g) {
+        chunk.push_back(v);
+        if (chunk.size() == size) {
+            co_yield std::span<const std::uint64_t>(chunk);
+            chunk.clear();
+        }
     }
-  }
+    if (!chunk.empty())
+        co_yield std::span<const std::uint64_t>(chunk);
+}
+
+template <typename Generator>
+static Generator interleave_coroutine(Generator a, Generator b) {
+    auto ia = a.begin(), ib = b.begin();
+    for (; ia != a.end() && ib != b.end(); ++ia, ++ib) {
+        co_yield *ia;
+        co_yield *ib;
+    }
+    for (; ia != a.end(); ++ia)
+        co_yield *ia;
+    for (; ib != b.end(); ++ib)
+        co_yield *ib;
 }
 
+// Each combinator over n values of iota(), as an adaptor and as a
+// wrapping coroutine.
+template <template <typename...> class Generator>
+struct concat_combinator {
+    static auto adaptor(std::uint64_t n) {
+        return combinators::concat(iota<Generator<std::uint64_t>>(n / 2), iota<Generator<std::uint64_t>>(n - n / 2));
+    }
+    static auto coroutine(std::uint64_t n) {
+        return concat_coroutine(iota<Generator<std::uint64_t>>(n / 2), iota<Generator<std::uint64_t>>(n - n / 2));
+    }
+};
 
+template <template <typename...> class Generator>
+struct zip_combinator {
+    static auto adaptor(std::uint64_t n) {
+        return combinators::zip(iota<Generator<std::uint64_t>>(n), iota<Generator<std::uint64_t>>(n));
+    }
+    static auto coroutine(std::uint64_t n) {
+        return zip_coroutine<Generator>(iota<Generator<std::uint64_t>>(n), iota<Generator<std::uint64_t>>(n));
+    }
+};
 
-BENCHMARK_TEMPLATE(BM_Dummy, simple::generator<uint64_t>);
-BENCHMARK_TEMPLATE(BM_Dummy, recursive::generator<uint64_t>);
+template <template <typename...> class Generator>
+struct enumerate_combinator {
+    static auto adaptor(std::uint64_t n) {
+        return combinators::enumerate(iota<Generator<std::uint64_t>>(n));
+    }
+    static auto coroutine(std::uint64_t n) {
+        return enumerate_coroutine<Generator>(iota<Generator<std::uint64_t>>(n));
+    }
+};
 
-BENCHMARK_TEMPLATE(BM_DummyNoInline, simple::generator<uint64_t>);
-BENCHMARK_TEMPLATE(BM_DummyNoInline, recursive::generator<uint64_t>);
+template <template <typename...> class Generator>
+struct chunk_combinator {
+    static auto adaptor(std::uint64_t n) {
+        return combinators::chunk(iota<Generator<std::uint64_t>>(n), 64);
+    }
+    static auto coroutine(std::uint64_t n) {
+        return chunk_coroutine<Generator>(iota<Generator<std::uint64_t>>(n), 64);
+    }
+};
+
+template <template <typename...> class Generator>
+struct interleave_combinator {
+    static auto adaptor(std::uint64_t n) {
+        return combinators::interleave(iota<Generator<std::uint64_t>>(n / 2), iota<Generator<std::uint64_t>>(n - n / 2));
+    }
+    static auto coroutine(std::uint64_t n) {
+        return interleave_coroutine(iota<Generator<std::uint64_t>>(n / 2), iota<Generator<std::uint64_t>>(n - n / 2));
+    }
+};
 
-BENCHMARK_TEMPLATE(BM_Fib, simple::generator<uint64_t>);
-BENCHMARK_TEMPLATE(BM_Fib, recursive::generator<uint64_t>);
+// Elements of a chunk one by one, anything else as a whole.
+template <typename T>
+static void consume(T&& v) {
+    if constexpr (std::ranges::range<T>) {
+        for (auto&& e : v)
+            benchmark::DoNotOptimize(e);
+    } else {
+        benchmark::DoNotOptimize(v);
+    }
+}
 
-BENCHMARK_TEMPLATE(BM_FibNoInline, simple::generator<uint64_t>);
-BENCHMARK_TEMPLATE(BM_FibNoInline, recursive::generator<uint64_t>);
+// Values too large to be cheap to copy, yielded as a copy of a local
+// object, built in place in the generator with construct_in_place(), or
+// by address (storage_policy::address) with no construction at all. With
+// the value type as reference type, the first two are dereferenced as a
+// copy too: one copy per element for a local object, and one for an
+// object built in place, which the third does without.
+template <std::size_t Bytes>
+struct pod {
+    pod() noexcept = default;
+    explicit pod(std::uint64_t seed) noexcept {
+        std::fill(std::begin(words), std::end(words), seed);
+    }
+    std::uint64_t words[Bytes / sizeof(std::uint64_t)];
+};
 
-BENCHMARK(BM_Range);
-BENCHMARK(BM_RangeSymmetricTransfer);
+// Constructor arguments of the i-th payload.
+template <typename T>
+static auto payload_args(std::uint64_t i) {
+    if constexpr (std::is_same_v<T, std::string>)
+        return std::tuple(std::size_t(48), char('a' + i % 26));
+    else if constexpr (std::is_same_v<T, std::vector<std::uint64_t>>)
+        return std::tuple(std::size_t(16), i);
+    else
+        return std::tuple(i);
+}
 
-BENCHMARK(BM_DeepRecursion);
-BENCHMARK(BM_DeepSymmetricTransfer);
+template <typename Generator>
+static Generator yield_local(std::uint64_t n) {
+    using T = typename Generator::iterator::value_type;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        T value = std::make_from_tuple<T>(payload_args<T>(i));
+        co_yield value;
+    }
+}
 
+template <typename Generator>
+static Generator yield_in_place(std::uint64_t n) {
+    using T = typename Generator::iterator::value_type;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        auto args = payload_args<T>(i);
+        co_yield std::apply([](auto&... a) { return construct_in_place(a...); }, args);
+    }
+}
 
-BENCHMARK_MAIN();
\ No newline at end of file
+// Sorted stream of n values with random gaps, so that streams merged
+// together interleave irregularly.
+template <typename Generator>
+static Generator sorted_run(std::uint64_t seed, std::uint64_t n) {
+    std::uint64_t value = 0;
+    seed = seed * 0x9e3779b97f4a7c15 + 1;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        value += seed % 64;
+        co_yield value;
+    }
+}
+
+template <typename Generator>
+static std::vector<Generator> sorted_runs(std::size_t k, std::uint64_t total) {
+    std::vector<Generator> runs;
+    runs.reserve(k);
+    for (std::size_t i = 0; i < k; ++i)
+        runs.push_back(sorted_run<Generator>(i, total / k + (i < total % k)));
+    return runs;
+}
+
+// The integers below n, announced with a size hint...
+template <typename Generator>
+static Generator hinted_iota(std::uint64_t n) {
+    co_yield size_hint{n};
+    for (std::uint64_t i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// ... or yielded by blocks of 1024.
+template <typename Generator>
+static Generator iota_blocks(std::uint64_t n) {
+    std::array<std::uint64_t, 1024> block;
+    for (std::uint64_t i = 0; i < n; i += block.size()) {
+        const auto count = std::min<std::uint64_t>(block.size(), n - i);
+        for (std::uint64_t j = 0; j < count; ++j)
+            block[j] = i + j;
+        co_yield std::span<const std::uint64_t>(block.data(), count);
+    }
+}
+
+// Trees of n nodes for the in-order traversal benchmarks. Their shape is
+// balanced (subtrees of equal sizes), skewed (the first subtree of each
+// node holds 90% of its descendants) or random (uniform split points),
+// with up to `arity` children per node. Nodes are numbered in breadth-first
+// order and hold their number as value.
+enum class tree_shape { balanced, skewed, random };
+
+// Number of children of each node, in breadth-first order.
+static std::vector<std::uint32_t> tree_child_counts(std::size_t n, tree_shape shape, int arity) {
+    std::vector<std::uint32_t> counts;
+    std::vector<std::size_t> sizes{n};
+    counts.reserve(n);
+    sizes.reserve(n);
+    std::vector<std::size_t> cuts(arity);
+    std::uint64_t seed = 0x9e3779b97f4a7c15;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t rest = sizes[i] - 1;
+        const std::size_t before = sizes.size();
+        for (int c = 0; c < arity; ++c) {
+            std::size_t size;
+            if (shape == tree_shape::balanced) {
+                size = rest / arity + (std::size_t(c) < rest % arity);
+            } else if (shape == tree_shape::skewed) {
+                const std::size_t others = rest / 10;
+                size = c == 0 ? rest - others : others / (arity - 1) + (std::size_t(c - 1) < others % (arity - 1));
+            } else {
+                if (c == 0) {
+                    for (int k = 0; k < arity - 1; ++k) {
+                        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+                        cuts[k] = seed % (rest + 1);
+                    }
+                    cuts[arity - 1] = rest;
+                    std::sort(cuts.begin(), cuts.end());
+                }
+                size = cuts[c] - (c == 0 ? 0 : cuts[c - 1]);
+            }
+            if (size != 0)
+                sizes.push_back(size);
+        }
+        counts.push_back(std::uint32_t(sizes.size() - before));
+    }
+    return counts;
+}
+
+// Nodes in one array, in breadth-first order, linked by indices: the
+// children of a node are contiguous.
+class array_tree {
+  public:
+    using node = std::uint32_t;
+    static constexpr node none = ~node(0);
+
+    array_tree(std::size_t n, tree_shape shape, int arity) : nodes_(n) {
+        const auto counts = tree_child_counts(n, shape, arity);
+        node next = 1;
+        for (std::size_t i = 0; i < n; ++i)
+            nodes_[i] = {i, none, none};
+        for (std::size_t i = 0; i < n; ++i) {
+            nodes_[i].first_child = counts[i] ? next : none;
+            for (std::uint32_t c = 0; c + 1 < counts[i]; ++c)
+                nodes_[next + c].next_sibling = next + c + 1;
+            next += counts[i];
+        }
+    }
+
+    std::size_t size() const noexcept {
+        return nodes_.size();
+    }
+    node root() const noexcept {
+        return 0;
+    }
+    node first_child(node n) const noexcept {
+        return nodes_[n].first_child;
+    }
+    node next_sibling(node n) const noexcept {
+        return nodes_[n].next_sibling;
+    }
+    std::uint64_t value(node n) const noexcept {
+        return nodes_[n].value;
+    }
+
+  private:
+    struct entry {
+        std::uint64_t value;
+        node first_child;
+        node next_sibling;
+    };
+    std::vector<entry> nodes_;
+};
+
+// Nodes allocated one by one, in random order, and linked by pointers:
+// every step of a traversal is a dependent load from anywhere in the heap.
+class pointer_tree {
+    struct entry {
+        std::uint64_t value;
+        const entry* first_child;
+        const entry* next_sibling;
+    };
+
+  public:
+    using node = const entry*;
+    static constexpr node none = nullptr;
+
+    pointer_tree(std::size_t n, tree_shape shape, int arity) : nodes_(n) {
+        const array_tree links(n, shape, arity);
+        std::vector<std::uint32_t> order(n);
+        for (std::size_t i = 0; i < n; ++i)
+            order[i] = i;
+        std::uint64_t seed = 0x2545f4914f6cdd1d;
+        for (std::size_t i = n; i > 1; --i) {
+            seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+            std::swap(order[i - 1], order[seed % i]);
+        }
+        for (auto i : order)
+            nodes_[i] = std::make_unique<entry>();
+        auto address = [&](array_tree::node i) { return i == array_tree::none ? none : nodes_[i].get(); };
+        for (std::size_t i = 0; i < n; ++i)
+            *nodes_[i] = {links.value(i), address(links.first_child(i)), address(links.next_sibling(i))};
+    }
+
+    std::size_t size() const noexcept {
+        return nodes_.size();
+    }
+    node root() const noexcept {
+        return nodes_[0].get();
+    }
+    node first_child(node n) const noexcept {
+        return n->first_child;
+    }
+    node next_sibling(node n) const noexcept {
+        return n->next_sibling;
+    }
+    std::uint64_t value(node n) const noexcept {
+        return n->value;
+    }
+
+  private:
+    std::vector<std::unique_ptr<entry>> nodes_;
+};
+
+// Complete tree in the Eytzinger layout: the children of node i are
+// arity * i + 1 to arity * i + arity, so that only the values are stored.
+// Complete trees being balanced, the shape is ignored.
+class eytzinger_tree {
+  public:
+    using node = std::uint32_t;
+    static constexpr node none = ~node(0);
+
+    eytzinger_tree(std::size_t n, tree_shape, int arity) : values_(n), arity_(arity) {
+        for (std::size_t i = 0; i < n; ++i)
+            values_[i] = i;
+    }
+
+    std::size_t size() const noexcept {
+        return values_.size();
+    }
+    node root() const noexcept {
+        return 0;
+    }
+    node first_child(node n) const noexcept {
+        const std::size_t child = std::size_t(arity_) * n + 1;
+        return child < values_.size() ? node(child) : none;
+    }
+    node next_sibling(node n) const noexcept {
+        return n % arity_ != 0 && n + 1 < values_.size() ? n + 1 : none;
+    }
+    std::uint64_t value(node n) const noexcept {
+        return values_[n];
+    }
+
+  private:
+    std::vector<std::uint64_t> values_;
+    std::uint32_t arity_;
+};
+
+// The tree of the last arguments it was called with, built once for all
+// the runs of a benchmark rather than on every call. The threads of a
+// threaded run all ask for the same tree and share it.
+template <typename Tree>
+static const Tree& shaped_tree(std::size_t n, tree_shape shape, int arity) {
+    static std::mutex mutex;
+    static std::unique_ptr<Tree> tree;
+    static std::tuple<std::size_t, tree_shape, int> built;
+    std::lock_guard lock(mutex);
+    if (!tree || built != std::tuple(n, shape, arity)) {
+        tree.reset();
+        tree = std::make_unique<Tree>(n, shape, arity);
+        built = {n, shape, arity};
+    }
+    return *tree;
+}
+
+// In-order traversal, generalized to n-ary trees: the subtree of the first
+// child, then the node, then the subtrees of the other children. Every
+// node is a generator, entered from its parent through elements_of.
+template <typename Generator, typename Tree>
+static Generator in_order(const Tree& tree, typename Tree::node n) {
+    auto child = tree.first_child(n);
+    if (child != Tree::none)
+        co_yield elements_of(in_order<Generator>(tree, child));
+    co_yield tree.value(n);
+    if (child == Tree::none)
+        co_return;
+    while ((child = tree.next_sibling(child)) != Tree::none)
+        co_yield elements_of(in_order<Generator>(tree, child));
+}
+
+// Same, with every value passed up through each level of nested loops:
+// a value at depth d costs d resumptions.
+template <typename Generator, typename Tree>
+static Generator in_order_nested(const Tree& tree, typename Tree::node n) {
+    auto child = tree.first_child(n);
+    if (child != Tree::none) {
+        for(auto && v : in_order_nested<Generator>(tree, child)) {
+            co_yield v;
+        }
+    }
+    co_yield tree.value(n);
+    if (child == Tree::none)
+        co_return;
+    while ((child = tree.next_sibling(child)) != Tree::none) {
+        for(auto && v : in_order_nested<Generator>(tree, child)) {
+            co_yield v;
+        }
+    }
+}
+
+// Same order as in_order, with an explicit stack of the nodes on the path
+// from the root, each with its next child to visit.
+template <typename Tree>
+class in_order_cursor {
+  public:
+    explicit in_order_cursor(const Tree& tree) : tree_(tree) {
+        descend(tree.root());
+    }
+
+    bool next() {
+        while (!stack_.empty()) {
+            auto& top = stack_.back();
+            if (!top.visited) {
+                top.visited = true;
+                value_ = tree_.value(top.node);
+                return true;
+            }
+            if (top.child != Tree::none) {
+                const auto child = top.child;
+                top.child = tree_.next_sibling(child);
+                descend(child);
+                continue;
+            }
+            stack_.pop_back();
+        }
+        return false;
+    }
+
+    std::uint64_t value() const noexcept {
+        return value_;
+    }
+
+  private:
+    struct frame {
+        typename Tree::node node;
+        typename Tree::node child;
+        bool visited;
+    };
+
+    // Pushes n and its first descendants down to a leaf, the first
+    // child of each being visited before it.
+    void descend(typename Tree::node n) {
+        for (;;) {
+            const auto first = tree_.first_child(n);
+            stack_.push_back({n, first == Tree::none ? Tree::none : tree_.next_sibling(first), false});
+            if (first == Tree::none)
+                return;
+            n = first;
+        }
+    }
+
+    const Tree& tree_;
+    std::vector<frame> stack_;
+    std::uint64_t value_ = 0;
+};
+
+// Directory-like tree: every node yields a few entries of its own, then
+// the contents of its `fanout` sub-directories.
+template <typename Generator>
+static Generator directory_tree(int depth, int fanout) {
+    for(int i = 0; i < 4; ++i) {
+        co_yield depth;
+    }
+    if(depth == 0) {
+        co_return;
+    }
+    for(int i = 0; i < fanout; ++i) {
+        co_yield elements_of(directory_tree<Generator>(depth - 1, fanout));
+    }
+}
+
+struct sum_sink {
+    std::uint64_t sum = 0;
+
+    void operator()(int v) {
+        sum += v;
+    }
+};
+
+// Stand-in for parsing or decompression: `work` dependent multiplications.
+static std::uint64_t busy_work(std::uint64_t x, int work) {
+    for(int i = 0; i < work; ++i) {
+        x = x * 6364136223846793005u + 1442695040888963407u;
+    }
+    return x;
+}
+
+static simple::generator<std::uint64_t> expensive_source(int n, int work) {
+    for(int i = 0; i < n; ++i) {
+        co_yield busy_work(i, work);
+    }
+}
+
+// Per-value work of the parallel_for_each benchmarks, summing its results.
+struct busy_sum {
+    int work;
+    std::uint64_t sum = 0;
+
+    void operator()(std::uint64_t v) {
+        sum += busy_work(v, work);
+    }
+};
+
+#if defined(__linux__)
+struct record {
+    std::uint64_t key;
+    std::byte payload[56];
+};
+
+// One socketpair per stream; records are written to writers and read
+// from readers.
+struct socket_streams {
+    std::vector<int> readers, writers;
+
+    socket_streams(int count, bool nonBlockingReaders) {
+        for(int i = 0; i < count; ++i) {
+            int fds[2];
+            if(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+                throw std::system_error(errno, std::system_category(), "socketpair");
+            }
+            if(nonBlockingReaders) {
+                ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+            }
+            readers.push_back(fds[0]);
+            writers.push_back(fds[1]);
+        }
+    }
+
+    ~socket_streams() {
+        for(int fd : readers) ::close(fd);
+        for(int fd : writers) ::close(fd);
+    }
+};
+
+// Writes `count` records to each descriptor, a few at a time and round robin.
+static void write_records(const std::vector<int>& fds, int count) {
+    record batch[64] = {};
+    for(std::size_t i = 0; i < std::size(batch); ++i) {
+        batch[i].key = i;
+    }
+    for(int written = 0; written < count; written += std::size(batch)) {
+        const std::size_t bytes = std::min<std::size_t>(count - written, std::size(batch)) * sizeof(record);
+        for(int fd : fds) {
+            for(std::size_t done = 0; done < bytes;) {
+                const auto n = ::write(fd, reinterpret_cast<const char*>(batch) + done, bytes - done);
+                if(n < 0) {
+                    throw std::system_error(errno, std::system_category(), "write");
+                }
+                done += n;
+            }
+        }
+    }
+}
+
+static async::generator<const record&> read_records(epoll_executor& executor, int fd, int count) {
+    record buffer[64];
+    std::size_t bytes = 0;
+    while(count > 0) {
+        const auto n = ::read(fd, reinterpret_cast<char*>(buffer) + bytes, sizeof(buffer) - bytes);
+        if(n < 0) {
+            if(errno != EAGAIN) {
+                throw std::system_error(errno, std::system_category(), "read");
+            }
+            co_await executor.readable(fd);
+            continue;
+        }
+        if(n == 0) {
+            co_return;
+        }
+        bytes += n;
+        const std::size_t complete = bytes / sizeof(record);
+        for(std::size_t i = 0; i < complete; ++i) {
+            co_yield buffer[i];
+        }
+        count -= complete;
+        bytes -= complete * sizeof(record);
+        std::memmove(buffer, buffer + complete, bytes);
+    }
+}
+
+static fire_and_forget sum_records(async::generator<const record&> records, std::uint64_t& sum) {
+    while(auto* r = co_await records.next()) {
+        sum += r->key;
+    }
+}
+
+static std::uint64_t sum_records_blocking(int fd, int count) {
+    std::uint64_t sum = 0;
+    record buffer[64];
+    std::size_t bytes = 0;
+    while(count > 0) {
+        const auto n = ::read(fd, reinterpret_cast<char*>(buffer) + bytes, sizeof(buffer) - bytes);
+        if(n <= 0) {
+            break;
+        }
+        bytes += n;
+        const std::size_t complete = bytes / sizeof(record);
+        for(std::size_t i = 0; i < complete; ++i) {
+            sum += buffer[i].key;
+        }
+        count -= complete;
+        bytes -= complete * sizeof(record);
+        std::memmove(buffer, buffer + complete, bytes);
+    }
+    return sum;
+}
+
+// Record files for the mapped_records benchmarks, generated in $TMPDIR on
+// first use. BENCH_RECORDS_BYTES sets their size, 2 GiB by default.
+// Records are 16 to 200 bytes long; with a page cache large enough, the
+// benchmarks measure reads of a cached file.
+//
+// The file is unlinked as soon as it is created and only reached through
+// its descriptor, as /proc/self/fd/N, so that it goes away with the
+// process however the process ends.
+class record_file {
+  public:
+    explicit record_file(record_framing framing) {
+        const char* dir = std::getenv("TMPDIR");
+        std::string name = std::string(dir && *dir ? dir : "/tmp") + "/bench_records_XXXXXX";
+        fd_ = ::mkstemp(name.data());
+        if (fd_ < 0)
+            throw std::system_error(errno, std::system_category(), "mkstemp");
+        ::unlink(name.c_str());
+        path_ = "/proc/self/fd/" + std::to_string(fd_);
+        try {
+            write(framing);
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    record_file(const record_file&) = delete;
+    record_file& operator=(const record_file&) = delete;
+
+    ~record_file() {
+        ::close(fd_);
+    }
+
+    const char* path() const noexcept {
+        return path_.c_str();
+    }
+    std::uint64_t bytes() const noexcept {
+        return bytes_;
+    }
+    std::uint64_t records() const noexcept {
+        return records_;
+    }
+
+    static const record_file& get(record_framing framing) {
+        if (framing == record_framing::newline) {
+            static const record_file newline(framing);
+            return newline;
+        }
+        static const record_file prefixed(framing);
+        return prefixed;
+    }
+
+  private:
+    void write(record_framing framing) {
+        const char* size = std::getenv("BENCH_RECORDS_BYTES");
+        const std::uint64_t target = size ? std::strtoull(size, nullptr, 0) : std::uint64_t(2) << 30;
+        std::vector<char> buffer;
+        std::uint64_t seed = 0x9e3779b97f4a7c15;
+        while (bytes_ < target) {
+            buffer.clear();
+            while (buffer.size() < (1 << 20)) {
+                seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+                const std::uint32_t length = 16 + seed % 185;
+                if (framing == record_framing::length_prefixed) {
+                    for (int b = 0; b < 4; ++b)
+                        buffer.push_back(char(length >> (8 * b)));
+                }
+                buffer.insert(buffer.end(), length, char('a' + seed % 26));
+                if (framing == record_framing::newline)
+                    buffer.push_back('\n');
+                ++records_;
+            }
+            for (std::size_t done = 0; done < buffer.size();) {
+                const auto n = ::write(fd_, buffer.data() + done, buffer.size() - done);
+                if (n < 0)
+                    throw std::system_error(errno, std::system_category(), "write");
+                done += n;
+            }
+            bytes_ += buffer.size();
+        }
+    }
+
+    int fd_ = -1;
+    std::string path_;
+    std::uint64_t bytes_ = 0;
+    std::uint64_t records_ = 0;
+};
+
+// Reads a record file through a buffer of `capacity` bytes with read(),
+// moving the incomplete last record to the front before each read.
+template <typename F>
+static void read_records_buffered(const char* path, record_framing framing, std::size_t capacity, F&& f) {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::system_category(), "open");
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<char> buffer(capacity);
+    std::size_t filled = 0;
+    for (;;) {
+        const auto n = ::read(fd, buffer.data() + filled, buffer.size() - filled);
+        if (n < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "read");
+        }
+        filled += n;
+        const char* p = buffer.data();
+        const char* const end = p + filled;
+        if (framing == record_framing::newline) {
+            while (const auto* newline = static_cast<const char*>(std::memchr(p, '\n', end - p))) {
+                f(std::string_view(p, newline - p));
+                p = newline + 1;
+            }
+            if (n == 0 && p != end) {
+                f(std::string_view(p, end - p));
+                p = end;
+            }
+        } else {
+            while (end - p >= 4 && detail::load_le32(p) <= std::uint64_t(end - p - 4)) {
+                f(std::string_view(p + 4, detail::load_le32(p)));
+                p += 4 + detail::load_le32(p);
+            }
+        }
+        if (n == 0)
+            break;
+        filled = end - p;
+        std::memmove(buffer.data(), p, filled);
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);
+    }
+    ::close(fd);
+}
+#endif
+
+
+// The workloads of BM_Dummy, BM_Fib, BM_Range and BM_DeepRecursion for
+// each baseline.
+template <typename Baseline>
+static void BM_DummyBaseline(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Baseline::dummy([](auto&& v) { benchmark::DoNotOptimize(v); });
+  }
+}
+
+template <typename Baseline>
+static void BM_FibBaseline(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Baseline::fib(n, [](auto&& v) { benchmark::DoNotOptimize(v); });
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+template <typename Baseline>
+static void BM_RangeBaseline(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Baseline::range(n, [](auto&& v) { benchmark::DoNotOptimize(v); });
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+template <typename Baseline>
+static void BM_DeepRecursionBaseline(benchmark::State& state) {
+  const int depth = state.range(0), leaf = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Baseline::tree(depth, 1, leaf, [](auto&& v) { benchmark::DoNotOptimize(v); });
+  }
+  state.SetItemsProcessed(state.iterations() * leaf);
+  state.SetComplexityN(depth);
+}
+
+template <typename Generator>
+static void BM_Dummy(benchmark::State& state) {
+  // Perform setup here
+  perf_scope perf(state);
+  if constexpr (expect_elision<Generator>)
+    perf.expect_elided_frames();
+  for (auto _ : state) {
+    for(auto && v : dummy<Generator>()) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+}
+
+template <typename Generator>
+static void BM_DummyNoInline(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : dummy_no_inline<Generator>()) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+}
+
+// Frame in a buffer on the stack of the benchmark, reused by every
+// iteration: no heap allocation, whether or not the compiler elides.
+template <typename Generator>
+static void BM_DummyInBuffer(benchmark::State& state) {
+  inline_frame_buffer<256> buffer;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : dummy_in_buffer<Generator>(std::allocator_arg, inline_frame_allocator<>(buffer))) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  if (buffer.fallbacks() != 0)
+    state.SkipWithError("frame did not fit in the buffer");
+}
+
+template <typename Generator>
+static void BM_Fib(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : fib<Generator>(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+template <typename Generator>
+static void BM_FibNoInline(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : fib_no_inline<Generator>(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+template <typename Generator>
+static void BM_FibInBuffer(benchmark::State& state) {
+  const int n = state.range(0);
+  inline_frame_buffer<256> buffer;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : fib_in_buffer<Generator>(std::allocator_arg, inline_frame_allocator<>(buffer), n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  if (buffer.fallbacks() != 0)
+    state.SkipWithError("frame did not fit in the buffer");
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+static void BM_Range(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+static void BM_RangeSymmetricTransfer(benchmark::State& state) {
+  const int n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range_nested(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+// Linear chains of `depth` generators: the complexity is reported against
+// the depth, all the values being yielded by the last generator.
+static void BM_DeepRecursion(benchmark::State& state) {
+  const int depth = state.range(0), leaf = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : recursive_simple(depth, 1, leaf)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaf);
+  state.SetComplexityN(depth);
+}
+
+static void BM_DeepSymmetricTransfer(benchmark::State& state) {
+  const int depth = state.range(0), leaf = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : recursive_symmetric(depth, 1, leaf)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * leaf);
+  state.SetComplexityN(depth);
+}
+
+// Trees of generators: the complexity is reported against the number of
+// values yielded, which grows with the depth.
+static void BM_WideRecursion(benchmark::State& state) {
+  const int depth = state.range(0), fanout = state.range(1), leaf = state.range(2);
+  const auto n = tree_elements(depth, fanout, leaf);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : recursive_simple(depth, fanout, leaf)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+static void BM_WideSymmetricTransfer(benchmark::State& state) {
+  const int depth = state.range(0), fanout = state.range(1), leaf = state.range(2);
+  const auto n = tree_elements(depth, fanout, leaf);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : recursive_symmetric(depth, fanout, leaf)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetComplexityN(n);
+}
+
+// Keeps `state.range(0)` generators alive and replaces the oldest one on
+// every iteration, so that frames are not simply reused in place.
+template <typename Generator>
+static void BM_FrameChurn(benchmark::State& state) {
+  std::vector<Generator> live(state.range(0));
+  std::size_t next = 0;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    live[next] = dummy_no_inline<Generator>();
+    for(auto && v : live[next]) {
+        benchmark::DoNotOptimize(v);
+    }
+    next = next + 1 == live.size() ? 0 : next + 1;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Generator>
+static void BM_Chain(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : chain<Generator>(state.range(0), 1)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Stops after the given percentage of a spine, leaving that many frames
+// to tear down; 100 consumes it all.
+template <typename Generator>
+static void BM_SpineExit(benchmark::State& state) {
+  const int depth = state.range(0);
+  const std::int64_t stop = std::max<std::int64_t>(1, std::int64_t(depth) * state.range(1) / 100);
+  std::int64_t consumed = 0;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::int64_t n = 0;
+    for(auto && v : spine<Generator>(depth)) {
+        benchmark::DoNotOptimize(v);
+        if (++n == stop)
+            break;
+    }
+    consumed += n;
+  }
+  state.SetItemsProcessed(consumed);
+}
+
+// Only times the destruction of a started chain of the given depth.
+template <typename Generator>
+static void BM_ChainDestroy(benchmark::State& state) {
+  const int depth = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto g = chain<Generator>(depth, 1);
+    benchmark::DoNotOptimize(*g.begin());
+    state.ResumeTiming();
+    g = Generator{};
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+}
+
+static void BM_ChainArena(benchmark::State& state) {
+  frame_arena arena(frame_arena::huge_page_size, state.range(1));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : chain_arena(std::allocator_arg, frame_arena_allocator<>(arena), state.range(0), 1)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Generator>
+static void BM_Tree(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : tree<Generator>(state.range(0))) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (int64_t(1) << state.range(0)));
+}
+
+static void BM_TreeArena(benchmark::State& state) {
+  frame_arena arena(frame_arena::huge_page_size, state.range(1));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : tree_arena(std::allocator_arg, frame_arena_allocator<>(arena), state.range(0))) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (int64_t(1) << state.range(0)));
+}
+
+static void BM_ElementsOfVector(benchmark::State& state) {
+  std::vector<int> data(state.range(0), 42);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range_contiguous(data)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ElementsOfVectorAdapted(benchmark::State& state) {
+  std::vector<int> data(state.range(0), 42);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range_adapted(data)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <std::size_t N>
+static const std::array<int, N>& array_of_42() {
+  static const auto a = [] {
+    auto a = std::make_unique<std::array<int, N>>();
+    a->fill(42);
+    return a;
+  }();
+  return *a;
+}
+
+template <std::size_t N>
+static void BM_ElementsOfArray(benchmark::State& state) {
+  const auto& a = array_of_42<N>();
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range_contiguous(a)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+template <std::size_t N>
+static void BM_ElementsOfArrayAdapted(benchmark::State& state) {
+  const auto& a = array_of_42<N>();
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : range_adapted(a)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+#if defined(__linux__)
+static constexpr int stream_records = 1 << 18;
+
+// All the streams are consumed by async generators on a single thread.
+static void BM_AsyncStreams(benchmark::State& state) {
+  const int count = stream_records / state.range(0);
+  socket_streams streams(state.range(0), true);
+  epoll_executor executor;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    std::thread writer(write_records, std::cref(streams.writers), count);
+    for(int fd : streams.readers) {
+        sum_records(read_records(executor, fd, count), sum);
+    }
+    executor.run();
+    writer.join();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count * state.range(0));
+  state.SetBytesProcessed(state.iterations() * count * state.range(0) * sizeof(record));
+}
+
+// Each stream is consumed by a thread blocking on reads.
+static void BM_ThreadPerStream(benchmark::State& state) {
+  const int count = stream_records / state.range(0);
+  socket_streams streams(state.range(0), false);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::vector<std::uint64_t> sums(streams.readers.size());
+    std::vector<std::thread> readers;
+    for(std::size_t i = 0; i < streams.readers.size(); ++i) {
+        readers.emplace_back([&, i] { sums[i] = sum_records_blocking(streams.readers[i], count); });
+    }
+    write_records(streams.writers, count);
+    for(auto& t : readers) {
+        t.join();
+    }
+    benchmark::DoNotOptimize(sums.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count * state.range(0));
+  state.SetBytesProcessed(state.iterations() * count * state.range(0) * sizeof(record));
+}
+
+// Record files read as views into a mapping, whole or by windows of
+// `window_mb` MiB, with framing 0 for newlines and 1 for length prefixes.
+static void BM_RecordsMapped(benchmark::State& state) {
+  const auto framing = record_framing(state.range(0));
+  const std::size_t window = std::size_t(state.range(1)) << 20;
+  const auto& file = record_file::get(framing);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && record : mapped_records(file.path(), framing, window)) {
+        benchmark::DoNotOptimize(record);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * file.records());
+  state.SetBytesProcessed(state.iterations() * file.bytes());
+}
+
+// Copies every line twice: into the stream buffer, then into the string.
+static void BM_RecordsGetline(benchmark::State& state) {
+  const auto& file = record_file::get(record_framing::newline);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::ifstream in(file.path(), std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        benchmark::DoNotOptimize(line);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * file.records());
+  state.SetBytesProcessed(state.iterations() * file.bytes());
+}
+
+// Copies every record once, into a buffer of `buffer_kb` KiB.
+static void BM_RecordsRead(benchmark::State& state) {
+  const auto framing = record_framing(state.range(0));
+  const std::size_t capacity = std::size_t(state.range(1)) << 10;
+  const auto& file = record_file::get(framing);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    read_records_buffered(file.path(), framing, capacity, [](std::string_view record) {
+        benchmark::DoNotOptimize(record);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * file.records());
+  state.SetBytesProcessed(state.iterations() * file.bytes());
+}
+#endif
+
+static constexpr int read_ahead_items = 1 << 14;
+
+// Producer and consumer work on the same thread.
+static void BM_InlineProducer(benchmark::State& state) {
+  const int producerWork = state.range(0), consumerWork = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : expensive_source(read_ahead_items, producerWork)) {
+        benchmark::DoNotOptimize(busy_work(v, consumerWork));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * read_ahead_items);
+}
+
+// Producer running ahead on its own thread.
+static void BM_ReadAheadProducer(benchmark::State& state) {
+  const int producerWork = state.range(0), consumerWork = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    read_ahead values(expensive_source(read_ahead_items, producerWork), state.range(2), state.range(3));
+    for(auto && v : values) {
+        benchmark::DoNotOptimize(busy_work(v, consumerWork));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * read_ahead_items);
+}
+
+static constexpr int directory_depth = 7, directory_fanout = 8;
+
+template <typename Generator>
+static void BM_DirectoryTree(benchmark::State& state) {
+  std::int64_t n = 0;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    sum_sink sink;
+    n = 0;
+    for(auto && v : directory_tree<Generator>(directory_depth, directory_fanout)) {
+        sink(v);
+        ++n;
+    }
+    benchmark::DoNotOptimize(sink.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_DirectoryTreeParallel(benchmark::State& state) {
+  const auto n = 4 * tree_elements(directory_depth + 1, directory_fanout, 1) / (directory_fanout - 1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto sinks = parallel_traverse(directory_tree<Generator>(directory_depth, directory_fanout), state.range(0), sum_sink{});
+    benchmark::DoNotOptimize(sinks.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// The values of one cheap generator spread over `threads` threads, with
+// `work` multiplications per value, handed out by batches of `batch`:
+// in no particular order, then with the results put back in order. The
+// threads are started once, before the benchmark loop.
+static constexpr std::uint64_t parallel_values = 1 << 16;
+
+static void BM_ParallelForEach(benchmark::State& state) {
+  const int threads = state.range(0), work = state.range(1), batch = state.range(2);
+  worker_pool pool(threads);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto sums = parallel_for_each(iota<simple::generator<std::uint64_t>>(parallel_values), busy_sum{work}, pool, batch);
+    benchmark::DoNotOptimize(sums.data());
+  }
+  state.SetItemsProcessed(state.iterations() * parallel_values);
+}
+
+static void BM_ParallelTransform(benchmark::State& state) {
+  const int threads = state.range(0), work = state.range(1), batch = state.range(2);
+  worker_pool pool(threads);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    parallel_transform(iota<simple::generator<std::uint64_t>>(parallel_values),
+                       [work](std::uint64_t v) { return busy_work(v, work); },
+                       [&sum](std::uint64_t r) { sum += r; }, pool, batch);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * parallel_values);
+}
+
+// One suspension and one consumer step per element.
+template <typename Generator, typename Workload>
+static void BM_ElementYield(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Workload w;
+    for(auto && v : random_elements<Generator>(state.range(0))) {
+        w(v);
+    }
+    benchmark::DoNotOptimize(w.result());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// One suspension per block, one consumer step per element.
+template <typename Generator, typename Workload>
+static void BM_BlockYieldFlat(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Workload w;
+    for(auto && v : random_blocks<Generator>(state.range(0), state.range(1))) {
+        w(v);
+    }
+    benchmark::DoNotOptimize(w.result());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// One suspension and one consumer step per block.
+template <typename Generator, typename Workload>
+static void BM_BlockYieldChunks(benchmark::State& state) {
+  perf_scope perf(state);
+  for (auto _ : state) {
+    Workload w;
+    auto gen = random_blocks<Generator>(state.range(0), state.range(1));
+    for(auto block : gen.chunks()) {
+        w(block);
+    }
+    benchmark::DoNotOptimize(w.result());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define PIPELINE_BENCHMARK(name, make)                                  \
+template <typename Generator, int Stages>                               \
+static void name(benchmark::State& state) {                             \
+  const std::size_t n = state.range(0);                                 \
+  std::size_t consumed = 0;                                             \
+  perf_scope perf(state);                                               \
+  for (auto _ : state) {                                                \
+    for(auto && v : make<Stages>(iota<Generator>(n), n)) {              \
+        benchmark::DoNotOptimize(v);                                    \
+        ++consumed;                                                     \
+    }                                                                   \
+  }                                                                     \
+  state.SetItemsProcessed(consumed);                                    \
+}
+
+PIPELINE_BENCHMARK(BM_PipelineFused, fused_pipeline)
+PIPELINE_BENCHMARK(BM_PipelineViews, views_pipeline)
+PIPELINE_BENCHMARK(BM_PipelineNested, nested_pipeline)
+
+// Timed and untimed versions of the same generators: the latency
+// counters of the first, the cost of timing in the difference of the two.
+template <typename Generator>
+static void BM_LatencyIota(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  latency_scope latency(state);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : iota<Generator>(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Every value comes from a level deeper than the previous one; the last
+// resumption unwinds all the levels through final_suspend transfers.
+template <typename Generator>
+static void BM_LatencySpine(benchmark::State& state) {
+  const int depth = state.range(0);
+  latency_scope latency(state);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : spine<Generator>(depth)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+}
+
+// Enough frames in the tree for them to fall out of the caches.
+template <typename Generator>
+static void BM_LatencyTree(benchmark::State& state) {
+  const int depth = state.range(0);
+  latency_scope latency(state);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : tree<Generator>(depth)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (int64_t(1) << depth));
+}
+
+template <typename Combinator>
+static void BM_CombinatorAdaptor(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : Combinator::adaptor(n)) {
+        consume(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Combinator>
+static void BM_CombinatorCoroutine(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : Combinator::coroutine(n)) {
+        consume(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// k sorted streams of `total` values in all, merged by merge(), and by a
+// binary heap of the streams' heads as it is usually written by hand.
+template <typename Generator>
+static void BM_Merge(benchmark::State& state) {
+  const std::size_t k = state.range(0);
+  const std::uint64_t total = state.range(1);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : merge(sorted_runs<Generator>(k, total))) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * total);
+}
+
+template <typename Generator>
+static void BM_MergeHeap(benchmark::State& state) {
+  const std::size_t k = state.range(0);
+  const std::uint64_t total = state.range(1);
+  using value_type = typename Generator::iterator::value_type;
+  using head = std::pair<value_type, std::size_t>;
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto runs = sorted_runs<Generator>(k, total);
+    std::vector<typename Generator::iterator> its;
+    its.reserve(k);
+    std::priority_queue<head, std::vector<head>, std::greater<>> heads;
+    for (std::size_t i = 0; i < k; ++i) {
+      its.push_back(runs[i].begin());
+      if (its[i] != runs[i].end())
+        heads.emplace(*its[i], i);
+    }
+    while (!heads.empty()) {
+      const std::size_t i = heads.top().second;
+      benchmark::DoNotOptimize(heads.top().first);
+      heads.pop();
+      if (++its[i] != runs[i].end())
+        heads.emplace(*its[i], i);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * total);
+}
+
+// In-order traversals of the trees built by shaped_tree(nodes, shape,
+// arity): through nested recursive::generators, through nested loops of
+// simple::generators, and with an explicit stack.
+template <typename Generator, typename Tree>
+static void BM_TreeInOrder(benchmark::State& state) {
+  const auto& tree = shaped_tree<Tree>(state.range(0), tree_shape(state.range(1)), state.range(2));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : in_order<Generator>(tree, tree.root())) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * tree.size());
+}
+
+template <typename Generator, typename Tree>
+static void BM_TreeInOrderNested(benchmark::State& state) {
+  const auto& tree = shaped_tree<Tree>(state.range(0), tree_shape(state.range(1)), state.range(2));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : in_order_nested<Generator>(tree, tree.root())) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * tree.size());
+}
+
+template <typename Tree>
+static void BM_TreeInOrderCursor(benchmark::State& state) {
+  const auto& tree = shaped_tree<Tree>(state.range(0), tree_shape(state.range(1)), state.range(2));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for (in_order_cursor<Tree> c(tree); c.next();) {
+        benchmark::DoNotOptimize(c.value());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * tree.size());
+}
+
+// n values collected into a vector: pushed back one by one through the
+// iterator, then drained with to_vector(), without and with a size hint,
+// and from blocks.
+template <typename Generator>
+static void BM_CollectPushBack(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    std::vector<std::uint64_t> out;
+    for(auto && v : iota<Generator>(n)) {
+        out.push_back(v);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_CollectDrain(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto out = iota<Generator>(n).to_vector();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_CollectDrainHinted(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto out = hinted_iota<Generator>(n).to_vector();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_CollectDrainBlocks(benchmark::State& state) {
+  const std::uint64_t n = state.range(0);
+  perf_scope perf(state);
+  for (auto _ : state) {
+    auto out = iota_blocks<Generator>(n).to_vector();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_YieldLocal(benchmark::State& state) {
+  const auto n = std::uint64_t(state.range(0));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : yield_local<Generator>(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Generator>
+static void BM_YieldInPlace(benchmark::State& state) {
+  const auto n = std::uint64_t(state.range(0));
+  perf_scope perf(state);
+  for (auto _ : state) {
+    for(auto && v : yield_in_place<Generator>(n)) {
+        benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Copy of a local object, construction in place, and address of a local
+// object read through a const reference, for each payload type.
+#define PAYLOAD_BENCHMARKS(generator, T)                                                           \
+  BENCHMARK_TEMPLATE(BM_YieldLocal, generator<T, T>)->Arg(1024);                                  \
+  BENCHMARK_TEMPLATE(BM_YieldInPlace, generator<T, T>)->Arg(1024);                                \
+  BENCHMARK_TEMPLATE(BM_YieldLocal, generator<T, T, std::allocator<std::byte>, address_policy>)->Arg(1024)
+
+// Runs on 1 to hardware_concurrency threads, in wall-clock time, for
+// the contention on frame allocation to show in the scaling.
+static void threaded(benchmark::internal::Benchmark* b) {
+  b->ThreadRange(1, int(std::max(1u, std::thread::hardware_concurrency())))->UseRealTime();
+}
+
+// The single-threaded families under threaded() whose frames come from
+// the generator's allocator, for one frame allocation backend.
+// BM_FrameChurn frees frames out of order and is left out for the arena.
+#define THREADED_BENCHMARKS(simple_generator, recursive_generator)                                               \
+  BENCHMARK_TEMPLATE(BM_Dummy, simple_generator<uint64_t>)->Apply(threaded);                                    \
+  BENCHMARK_TEMPLATE(BM_Dummy, recursive_generator<uint64_t>)->Apply(threaded);                                 \
+  BENCHMARK_TEMPLATE(BM_DummyNoInline, simple_generator<uint64_t>)->Apply(threaded);                            \
+  BENCHMARK_TEMPLATE(BM_DummyNoInline, recursive_generator<uint64_t>)->Apply(threaded);                         \
+  BENCHMARK_TEMPLATE(BM_Fib, simple_generator<uint64_t>)->Arg(1024)->Apply(threaded);                           \
+  BENCHMARK_TEMPLATE(BM_Fib, recursive_generator<uint64_t>)->Arg(1024)->Apply(threaded);                        \
+  BENCHMARK_TEMPLATE(BM_FibNoInline, simple_generator<uint64_t>)->Arg(1024)->Apply(threaded);                   \
+  BENCHMARK_TEMPLATE(BM_FibNoInline, recursive_generator<uint64_t>)->Arg(1024)->Apply(threaded);                \
+  BENCHMARK_TEMPLATE(BM_Chain, recursive_generator<int>)->Arg(1000)->Apply(threaded);                           \
+  BENCHMARK_TEMPLATE(BM_ChainDestroy, recursive_generator<int>)->Arg(1000)->Apply(threaded);                    \
+  BENCHMARK_TEMPLATE(BM_Tree, recursive_generator<int>)->Arg(10)->Apply(threaded);                              \
+  BENCHMARK_TEMPLATE(BM_SpineExit, recursive_generator<int>)->Args({1000, 50})->Apply(threaded);                \
+  BENCHMARK_TEMPLATE(BM_TreeInOrder, recursive_generator<std::uint64_t>, pointer_tree)->Args({10000, 0, 2})->Apply(threaded); \
+  BENCHMARK_TEMPLATE(BM_YieldLocal, simple_generator<std::string>)->Arg(1024)->Apply(threaded);                 \
+  BENCHMARK_TEMPLATE(BM_YieldInPlace, simple_generator<std::string>)->Arg(1024)->Apply(threaded);               \
+  BENCHMARK_TEMPLATE(BM_YieldLocal, recursive_generator<std::string>)->Arg(1024)->Apply(threaded);              \
+  BENCHMARK_TEMPLATE(BM_YieldInPlace, recursive_generator<std::string>)->Arg(1024)->Apply(threaded);            \
+  BENCHMARK_TEMPLATE(BM_ElementYield, simple_generator<std::uint32_t>, sum_workload)->Args({1 << 12})->Apply(threaded); \
+  BENCHMARK_TEMPLATE(BM_ElementYield, recursive_generator<std::uint32_t>, sum_workload)->Args({1 << 12})->Apply(threaded)
+
+// The baselines under threaded(), as references for the scaling of the
+// generators.
+#define THREADED_BASELINE_BENCHMARKS(baseline)                                                                   \
+  BENCHMARK_TEMPLATE(BM_DummyBaseline, baseline)->Apply(threaded);                                              \
+  BENCHMARK_TEMPLATE(BM_FibBaseline, baseline)->Arg(1024)->Apply(threaded);                                     \
+  BENCHMARK_TEMPLATE(BM_RangeBaseline, baseline)->Arg(1 << 12)->Apply(threaded);                                \
+  BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, baseline)->Args({1000, 1})->Apply(threaded)
+
+#define THREADED_POLICY_BENCHMARKS(generator, policy)                                                            \
+  BENCHMARK_TEMPLATE(BM_Dummy, generator<uint64_t, policy>)->Apply(threaded);                                   \
+  BENCHMARK_TEMPLATE(BM_Fib, generator<uint64_t, policy>)->Arg(1024)->Apply(threaded)
+
+BENCHMARK_TEMPLATE(BM_Dummy, simple::generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_Dummy, recursive::generator<uint64_t>);
+
+BENCHMARK_TEMPLATE(BM_DummyNoInline, simple::generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, recursive::generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyBaseline, cursor_baseline);
+BENCHMARK_TEMPLATE(BM_DummyBaseline, callback_baseline);
+BENCHMARK_TEMPLATE(BM_DummyBaseline, function_baseline);
+#if defined(FIBER_GENERATOR_SUPPORTED)
+BENCHMARK_TEMPLATE(BM_DummyBaseline, fiber_baseline);
+#endif
+
+BENCHMARK_TEMPLATE(BM_Dummy, pooled_simple_generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_Dummy, pooled_recursive_generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, pooled_simple_generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, pooled_recursive_generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyInBuffer, inline_simple_generator<uint64_t>);
+BENCHMARK_TEMPLATE(BM_DummyInBuffer, inline_recursive_generator<uint64_t>);
+
+BENCHMARK_TEMPLATE(BM_Dummy, policy_simple_generator<uint64_t, terminate_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_simple_generator<uint64_t, eager_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_simple_generator<uint64_t, address_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_simple_generator<uint64_t, lean_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_recursive_generator<uint64_t, terminate_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_recursive_generator<uint64_t, address_policy>);
+BENCHMARK_TEMPLATE(BM_Dummy, policy_recursive_generator<uint64_t, lean_recursive_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_simple_generator<uint64_t, terminate_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_simple_generator<uint64_t, eager_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_simple_generator<uint64_t, address_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_simple_generator<uint64_t, lean_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_recursive_generator<uint64_t, terminate_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_recursive_generator<uint64_t, address_policy>);
+BENCHMARK_TEMPLATE(BM_DummyNoInline, policy_recursive_generator<uint64_t, lean_recursive_policy>);
+
+BENCHMARK_TEMPLATE(BM_FrameChurn, simple::generator<uint64_t>)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_FrameChurn, pooled_simple_generator<uint64_t>)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_FrameChurn, recursive::generator<uint64_t>)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_FrameChurn, pooled_recursive_generator<uint64_t>)->Range(1, 4096);
+
+BENCHMARK_TEMPLATE(BM_FrameChurn, simple::generator<uint64_t>)->Arg(64)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FrameChurn, pooled_simple_generator<uint64_t>)->Arg(64)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FrameChurn, recursive::generator<uint64_t>)->Arg(64)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FrameChurn, pooled_recursive_generator<uint64_t>)->Arg(64)->ThreadRange(1, 16)->UseRealTime();
+
+THREADED_BENCHMARKS(simple::generator, recursive::generator);
+THREADED_BENCHMARKS(pooled_simple_generator, pooled_recursive_generator);
+THREADED_BENCHMARKS(thread_arena_simple_generator, thread_arena_recursive_generator);
+BENCHMARK(BM_Range)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK(BM_RangeSymmetricTransfer)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK(BM_DeepRecursion)->Args({1000, 1})->Apply(threaded);
+BENCHMARK(BM_DeepSymmetricTransfer)->Args({1000, 1})->Apply(threaded);
+BENCHMARK(BM_WideRecursion)->Args({10, 2, 1})->Apply(threaded);
+BENCHMARK(BM_WideSymmetricTransfer)->Args({10, 2, 1})->Apply(threaded);
+
+// The other single-threaded families under threaded(), with the frame
+// allocation they have. Left out: BM_FrameChurn has its own thread
+// ranges; BM_AsyncStreams, BM_ThreadPerStream, BM_InlineProducer,
+// BM_ReadAheadProducer, BM_DirectoryTreeParallel, BM_ParallelForEach and
+// BM_ParallelTransform run threads of their own; BM_Records* measure
+// reads of a file, not generators.
+THREADED_BASELINE_BENCHMARKS(cursor_baseline);
+THREADED_BASELINE_BENCHMARKS(callback_baseline);
+THREADED_BASELINE_BENCHMARKS(function_baseline);
+#if defined(FIBER_GENERATOR_SUPPORTED)
+THREADED_BASELINE_BENCHMARKS(fiber_baseline);
+#endif
+THREADED_POLICY_BENCHMARKS(policy_simple_generator, terminate_policy);
+THREADED_POLICY_BENCHMARKS(policy_simple_generator, eager_policy);
+THREADED_POLICY_BENCHMARKS(policy_simple_generator, address_policy);
+THREADED_POLICY_BENCHMARKS(policy_simple_generator, lean_policy);
+THREADED_POLICY_BENCHMARKS(policy_recursive_generator, terminate_policy);
+THREADED_POLICY_BENCHMARKS(policy_recursive_generator, address_policy);
+THREADED_POLICY_BENCHMARKS(policy_recursive_generator, lean_recursive_policy);
+BENCHMARK_TEMPLATE(BM_DummyInBuffer, inline_simple_generator<uint64_t>)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_DummyInBuffer, inline_recursive_generator<uint64_t>)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_FibInBuffer, inline_simple_generator<uint64_t>)->Arg(1024)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_FibInBuffer, inline_recursive_generator<uint64_t>)->Arg(1024)->Apply(threaded);
+BENCHMARK(BM_ChainArena)->Args({1000, false})->Apply(threaded);
+BENCHMARK(BM_TreeArena)->Args({10, false})->Apply(threaded);
+BENCHMARK(BM_ElementsOfVector)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK(BM_ElementsOfVectorAdapted)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 4096)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 4096)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_simple_generator<std::uint32_t>, sum_workload)->Args({1 << 12, 256})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_simple_generator<std::uint32_t>, sum_workload)->Args({1 << 12, 256})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_recursive_generator<std::uint32_t>, sum_workload)->Args({1 << 12, 256})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_recursive_generator<std::uint32_t>, sum_workload)->Args({1 << 12, 256})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_simple_generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineViews, simple::generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineNested, simple::generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_recursive_generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineViews, recursive::generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_PipelineNested, recursive::generator<std::uint64_t>, 3)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencyIota, simple::generator<std::uint64_t>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencyIota, timed_simple_generator<std::uint64_t>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencySpine, recursive::generator<int>)->Arg(1000)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencySpine, timed_recursive_generator<int>)->Arg(1000)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencyTree, recursive::generator<int>)->Arg(10)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_LatencyTree, timed_recursive_generator<int>)->Arg(10)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, concat_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, concat_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, zip_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, zip_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, enumerate_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, enumerate_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, chunk_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, chunk_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, interleave_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, interleave_combinator<simple::generator>)->Arg(1 << 12)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_Merge, simple::generator<std::uint64_t>)->Args({8, 1 << 16})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_MergeHeap, simple::generator<std::uint64_t>)->Args({8, 1 << 16})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_TreeInOrderNested, simple::generator<std::uint64_t>, pointer_tree)->Args({10000, 0, 2})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_TreeInOrderCursor, pointer_tree)->Args({10000, 0, 2})->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CollectPushBack, simple::generator<std::uint64_t>)->Arg(1 << 16)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CollectDrain, simple::generator<std::uint64_t>)->Arg(1 << 16)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CollectDrainHinted, blocks_simple_generator<std::uint64_t>)->Arg(1 << 16)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_CollectDrainBlocks, blocks_simple_generator<std::uint64_t>)->Arg(1 << 16)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_YieldLocal, simple::generator<std::string, std::string, std::allocator<std::byte>, address_policy>)->Arg(1024)->Apply(threaded);
+BENCHMARK_TEMPLATE(BM_DirectoryTree, recursive::generator<int>)->Apply(threaded);
+
+BENCHMARK_TEMPLATE(BM_Fib, simple::generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_Fib, recursive::generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+
+BENCHMARK_TEMPLATE(BM_FibNoInline, simple::generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_FibNoInline, recursive::generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_FibBaseline, cursor_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_FibBaseline, callback_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_FibBaseline, function_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+#if defined(FIBER_GENERATOR_SUPPORTED)
+BENCHMARK_TEMPLATE(BM_FibBaseline, fiber_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+#endif
+BENCHMARK_TEMPLATE(BM_FibInBuffer, inline_simple_generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_FibInBuffer, inline_recursive_generator<uint64_t>)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+
+BENCHMARK_TEMPLATE(BM_Fib, policy_simple_generator<uint64_t, terminate_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_simple_generator<uint64_t, eager_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_simple_generator<uint64_t, address_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_simple_generator<uint64_t, lean_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_recursive_generator<uint64_t, terminate_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_recursive_generator<uint64_t, address_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Fib, policy_recursive_generator<uint64_t, lean_recursive_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_FibNoInline, policy_simple_generator<uint64_t, lean_policy>)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_FibNoInline, policy_recursive_generator<uint64_t, lean_recursive_policy>)->Arg(1024);
+
+BENCHMARK(BM_Range)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK(BM_RangeSymmetricTransfer)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_RangeBaseline, cursor_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_RangeBaseline, callback_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+BENCHMARK_TEMPLATE(BM_RangeBaseline, function_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+#if defined(FIBER_GENERATOR_SUPPORTED)
+BENCHMARK_TEMPLATE(BM_RangeBaseline, fiber_baseline)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity();
+#endif
+
+BENCHMARK(BM_ElementsOfVector)->RangeMultiplier(16)->Range(1, 1 << 20);
+BENCHMARK(BM_ElementsOfVectorAdapted)->RangeMultiplier(16)->Range(1, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 1);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 1);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 16);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 16);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 256);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 256);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 4096);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 4096);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 65536);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 65536);
+BENCHMARK_TEMPLATE(BM_ElementsOfArray, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ElementsOfArrayAdapted, 1 << 20);
+
+BENCHMARK(BM_DeepRecursion)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+BENCHMARK(BM_DeepSymmetricTransfer)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+BENCHMARK(BM_DeepRecursion)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+BENCHMARK(BM_DeepSymmetricTransfer)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, cursor_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, callback_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, function_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+#if defined(FIBER_GENERATOR_SUPPORTED)
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, fiber_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1}})->Complexity();
+#endif
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, cursor_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, callback_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, function_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+#if defined(FIBER_GENERATOR_SUPPORTED)
+BENCHMARK_TEMPLATE(BM_DeepRecursionBaseline, fiber_baseline)->ArgNames({"depth", "leaf"})->ArgsProduct({benchmark::CreateRange(1, 10000, 10), {1000}})->Complexity();
+#endif
+BENCHMARK(BM_WideRecursion)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 16, 1), {2}, {1}})->Complexity();
+BENCHMARK(BM_WideSymmetricTransfer)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 16, 1), {2}, {1}})->Complexity();
+BENCHMARK(BM_WideRecursion)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 10, 1), {2}, {64}})->Complexity();
+BENCHMARK(BM_WideSymmetricTransfer)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 10, 1), {2}, {64}})->Complexity();
+BENCHMARK(BM_WideRecursion)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 6, 1), {8}, {1}})->Complexity();
+BENCHMARK(BM_WideSymmetricTransfer)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 6, 1), {8}, {1}})->Complexity();
+BENCHMARK(BM_WideRecursion)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 4, 1), {8}, {64}})->Complexity();
+BENCHMARK(BM_WideSymmetricTransfer)->ArgNames({"depth", "fanout", "leaf"})->ArgsProduct({benchmark::CreateDenseRange(1, 4, 1), {8}, {64}})->Complexity();
+
+BENCHMARK_TEMPLATE(BM_Chain, recursive::generator<int>)->RangeMultiplier(10)->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_Chain, pooled_recursive_generator<int>)->RangeMultiplier(10)->Range(10, 1000000);
+BENCHMARK(BM_ChainArena)->ArgsProduct({benchmark::CreateRange(10, 1000000, 10), {false, true}});
+
+BENCHMARK_TEMPLATE(BM_SpineExit, recursive::generator<int>)->ArgNames({"depth", "percent"})->ArgsProduct({benchmark::CreateRange(1000, 10000000, 10), {1, 50, 100}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SpineExit, pooled_recursive_generator<int>)->ArgNames({"depth", "percent"})->ArgsProduct({benchmark::CreateRange(1000, 10000000, 10), {1, 50, 100}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ChainDestroy, recursive::generator<int>)->ArgName("depth")->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ChainDestroy, pooled_recursive_generator<int>)->ArgName("depth")->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_Tree, recursive::generator<int>)->DenseRange(4, 16, 4);
+BENCHMARK_TEMPLATE(BM_Tree, pooled_recursive_generator<int>)->DenseRange(4, 16, 4);
+BENCHMARK(BM_TreeArena)->ArgsProduct({benchmark::CreateDenseRange(4, 16, 4), {false, true}});
+
+BENCHMARK_TEMPLATE(BM_ElementYield, simple::generator<std::uint32_t>, sum_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_simple_generator<std::uint32_t>, sum_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_simple_generator<std::uint32_t>, sum_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+BENCHMARK_TEMPLATE(BM_ElementYield, recursive::generator<std::uint32_t>, sum_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_recursive_generator<std::uint32_t>, sum_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_recursive_generator<std::uint32_t>, sum_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+
+BENCHMARK_TEMPLATE(BM_ElementYield, simple::generator<std::uint32_t>, minmax_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_simple_generator<std::uint32_t>, minmax_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_simple_generator<std::uint32_t>, minmax_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+BENCHMARK_TEMPLATE(BM_ElementYield, recursive::generator<std::uint32_t>, minmax_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_recursive_generator<std::uint32_t>, minmax_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_recursive_generator<std::uint32_t>, minmax_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+
+BENCHMARK_TEMPLATE(BM_ElementYield, simple::generator<std::uint32_t>, histogram_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_simple_generator<std::uint32_t>, histogram_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_simple_generator<std::uint32_t>, histogram_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+BENCHMARK_TEMPLATE(BM_ElementYield, recursive::generator<std::uint32_t>, histogram_workload)->Args({1 << 16});
+BENCHMARK_TEMPLATE(BM_BlockYieldFlat, blocks_recursive_generator<std::uint32_t>, histogram_workload)->Args({1 << 16, 256});
+BENCHMARK_TEMPLATE(BM_BlockYieldChunks, blocks_recursive_generator<std::uint32_t>, histogram_workload)->Args({1 << 16, 16})->Args({1 << 16, 256})->Args({1 << 16, 4096});
+
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_simple_generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, simple::generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, simple::generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_simple_generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, simple::generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, simple::generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_simple_generator<std::uint64_t>, 6)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, simple::generator<std::uint64_t>, 6)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, simple::generator<std::uint64_t>, 6)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_recursive_generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, recursive::generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, recursive::generator<std::uint64_t>, 1)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_recursive_generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, recursive::generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, recursive::generator<std::uint64_t>, 3)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineFused, filtered_recursive_generator<std::uint64_t>, 6)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineViews, recursive::generator<std::uint64_t>, 6)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PipelineNested, recursive::generator<std::uint64_t>, 6)->Arg(1 << 16);
+
+BENCHMARK_TEMPLATE(BM_LatencyIota, simple::generator<std::uint64_t>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_LatencyIota, timed_simple_generator<std::uint64_t>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_LatencyIota, recursive::generator<std::uint64_t>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_LatencyIota, timed_recursive_generator<std::uint64_t>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_LatencySpine, recursive::generator<int>)->RangeMultiplier(100)->Range(10, 100000);
+BENCHMARK_TEMPLATE(BM_LatencySpine, timed_recursive_generator<int>)->RangeMultiplier(100)->Range(10, 100000);
+BENCHMARK_TEMPLATE(BM_LatencyTree, recursive::generator<int>)->DenseRange(8, 20, 6);
+BENCHMARK_TEMPLATE(BM_LatencyTree, timed_recursive_generator<int>)->DenseRange(8, 20, 6);
+
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, concat_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, concat_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, zip_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, zip_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, enumerate_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, enumerate_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, chunk_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, chunk_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, interleave_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, interleave_combinator<simple::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, concat_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, concat_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, zip_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, zip_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, enumerate_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, enumerate_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, chunk_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, chunk_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorAdaptor, interleave_combinator<recursive::generator>)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CombinatorCoroutine, interleave_combinator<recursive::generator>)->Arg(1 << 16);
+
+BENCHMARK_TEMPLATE(BM_Merge, simple::generator<std::uint64_t>)->ArgNames({"k", "total"})->ArgsProduct({{2, 8, 64, 1024}, {1 << 20, 100000000}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MergeHeap, simple::generator<std::uint64_t>)->ArgNames({"k", "total"})->ArgsProduct({{2, 8, 64, 1024}, {1 << 20, 100000000}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Merge, recursive::generator<std::uint64_t>)->ArgNames({"k", "total"})->ArgsProduct({{2, 8, 64, 1024}, {1 << 20, 100000000}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MergeHeap, recursive::generator<std::uint64_t>)->ArgNames({"k", "total"})->ArgsProduct({{2, 8, 64, 1024}, {1 << 20, 100000000}})->Unit(benchmark::kMillisecond);
+
+// Shapes 0 to 2 are balanced, skewed and random; the Eytzinger layout is
+// only balanced. Nested loops cost a resumption per level for every value,
+// hence the smaller trees.
+BENCHMARK_TEMPLATE(BM_TreeInOrder, recursive::generator<std::uint64_t>, pointer_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrder, recursive::generator<std::uint64_t>, array_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrder, recursive::generator<std::uint64_t>, eytzinger_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderNested, simple::generator<std::uint64_t>, pointer_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderNested, simple::generator<std::uint64_t>, array_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderNested, simple::generator<std::uint64_t>, eytzinger_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000}, {0}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderCursor, pointer_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderCursor, array_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0, 1, 2}, {2, 8}})->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_TreeInOrderCursor, eytzinger_tree)->ArgNames({"nodes", "shape", "arity"})->ArgsProduct({{1000, 100000, 10000000}, {0}, {2, 8}})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_CollectPushBack, simple::generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrain, simple::generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrainHinted, blocks_simple_generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrainBlocks, blocks_simple_generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectPushBack, recursive::generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrain, recursive::generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrainHinted, blocks_recursive_generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CollectDrainBlocks, blocks_recursive_generator<std::uint64_t>)->RangeMultiplier(100)->Range(1000, 100000000)->Unit(benchmark::kMicrosecond);
+
+PAYLOAD_BENCHMARKS(simple::generator, std::string);
+PAYLOAD_BENCHMARKS(simple::generator, std::vector<std::uint64_t>);
+PAYLOAD_BENCHMARKS(simple::generator, pod<64>);
+PAYLOAD_BENCHMARKS(simple::generator, pod<256>);
+PAYLOAD_BENCHMARKS(simple::generator, pod<1024>);
+PAYLOAD_BENCHMARKS(recursive::generator, std::string);
+PAYLOAD_BENCHMARKS(recursive::generator, std::vector<std::uint64_t>);
+PAYLOAD_BENCHMARKS(recursive::generator, pod<64>);
+PAYLOAD_BENCHMARKS(recursive::generator, pod<256>);
+PAYLOAD_BENCHMARKS(recursive::generator, pod<1024>);
+
+BENCHMARK(BM_InlineProducer)->ArgNames({"producer", "consumer"})->ArgsProduct({{0, 100, 1000}, {0, 100, 1000}})->UseRealTime();
+BENCHMARK(BM_ReadAheadProducer)->ArgNames({"producer", "consumer", "capacity", "batch"})->ArgsProduct({{0, 100, 1000}, {0, 100, 1000}, {1024}, {1, 64}})->UseRealTime();
+BENCHMARK(BM_ReadAheadProducer)->ArgNames({"producer", "consumer", "capacity", "batch"})->ArgsProduct({{100}, {100}, {64, 4096}, {16}})->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_DirectoryTree, recursive::generator<int>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DirectoryTree, pooled_recursive_generator<int>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DirectoryTreeParallel, spawnable_recursive_generator<int>)->ArgName("threads")->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DirectoryTreeParallel, spawnable_pooled_recursive_generator<int>)->ArgName("threads")->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+BENCHMARK(BM_ParallelForEach)->ArgNames({"threads", "work", "batch"})->ArgsProduct({{1, 2, 4, 8, 16}, {10, 1000}, {16, 256}})->UseRealTime();
+BENCHMARK(BM_ParallelTransform)->ArgNames({"threads", "work", "batch"})->ArgsProduct({{1, 2, 4, 8, 16}, {10, 1000}, {16, 256}})->UseRealTime();
+
+#if defined(__linux__)
+BENCHMARK(BM_AsyncStreams)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+BENCHMARK(BM_ThreadPerStream)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+BENCHMARK(BM_RecordsMapped)->ArgNames({"framing", "window_mb"})->ArgsProduct({{0, 1}, {0, 16, 256}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_RecordsGetline)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_RecordsRead)->ArgNames({"framing", "buffer_kb"})->ArgsProduct({{0, 1}, {64, 1024}})->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+
+
+// Same as BENCHMARK_MAIN(), with additional flags:
+// --perf_counters=<events> (or BENCH_PERF_COUNTERS environment variable)
+//   selects hardware counters among instructions, cycles, branch-misses,
+//   L1-dcache-load-misses and LLC-load-misses, or "all" of them.
+// --check_elision only runs the benchmarks expecting frame allocations to
+//   be elided, and fails if one of them allocated a frame. bench_counted
+//   only, frames not being counted otherwise.
+int main(int argc, char** argv) {
+  const char* events = std::getenv("BENCH_PERF_COUNTERS");
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    constexpr std::string_view flag = "--perf_counters=";
+    if (std::string_view(argv[i]).starts_with(flag))
+      events = argv[i] + flag.size();
+    else if (std::string_view(argv[i]) == "--check_elision")
+      check_elision = true;
+    else
+      argv[kept++] = argv[i];
+  }
+  argc = kept;
+  if (events && !perf::select_events(events))
+    return 1;
+#if !defined(GENERATOR_COUNT_FRAMES)
+  if (check_elision) {
+    std::fprintf(stderr, "--check_elision requires frame counting: run bench_counted\n");
+    return 1;
+  }
+#endif
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  if (check_elision)
+    benchmark::RunSpecifiedBenchmarks(elision_checks);
+  else
+    benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return elision_failed ? 1 : 0;
+}
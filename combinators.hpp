@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////
+// Combinators over generators, as plain iterator adaptors.
+//
+//   for (auto &&v : combinators::concat(std::move(a), std::move(b)))
+//   for (auto &&[x, y] : combinators::zip(std::move(a), std::move(b)))
+//   for (auto &&[i, v] : combinators::enumerate(std::move(a)))
+//   for (auto &&chunk : combinators::chunk(std::move(a), 16))
+//       for (auto &&v : chunk)
+//   for (auto &&v : combinators::interleave(std::move(a), std::move(b)))
+//
+// Each view owns its generators and drives their iterators directly, so
+// that combining generators costs no coroutine frame and no resumption
+// beyond those of the generators themselves, where a wrapping coroutine
+// (for (auto &&v : g) co_yield v;) costs one of each per element. Values
+// are passed through as the generators' iterators return them, move-only
+// ones included, and the views' iterators are move-only input iterators
+// like theirs.
+//
+// concat() and interleave() take generators of a single type. Works with
+// simple::generator and recursive::generator.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace combinators {
+
+struct sentinel {};
+
+namespace detail {
+
+template <typename Generator>
+bool exhausted(const typename Generator::iterator &it) noexcept {
+    return it == typename Generator::sentinel{};
+}
+
+} // namespace detail
+
+// Iterator of the views below, which forwards to the view it points to.
+template <typename View>
+class view_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using reference = typename View::reference;
+    using value_type = std::remove_cvref_t<reference>;
+
+    view_iterator() noexcept = default;
+    view_iterator(const view_iterator &) = delete;
+
+    view_iterator(view_iterator &&o) noexcept : view_(std::exchange(o.view_, {})) {
+    }
+
+    view_iterator &operator=(view_iterator &&o) noexcept {
+        std::swap(view_, o.view_);
+        return *this;
+    }
+
+    friend bool operator==(const view_iterator &it, sentinel) noexcept {
+        return it.done();
+    }
+
+    view_iterator &operator++() {
+        view_->next();
+        return *this;
+    }
+    void operator++(int) {
+        (void)operator++();
+    }
+
+    reference operator*() const {
+        return view_->get();
+    }
+
+  private:
+    friend View;
+    explicit view_iterator(View *view) noexcept : view_(view) {
+    }
+
+    bool done() const noexcept {
+        return !view_ || view_->done();
+    }
+
+    View *view_ = nullptr;
+};
+
+// The generators one after the other, each started once the previous one
+// is exhausted.
+template <typename Generator, std::size_t N>
+class concat_view {
+  public:
+    using reference = typename Generator::iterator::reference;
+    using iterator = view_iterator<concat_view>;
+
+    explicit concat_view(std::array<Generator, N> gens) : gens_(std::move(gens)) {
+    }
+
+    concat_view(const concat_view &) = delete;
+    concat_view &operator=(const concat_view &) = delete;
+
+    iterator begin() {
+        index_ = 0;
+        it_ = gens_[0].begin();
+        skip_exhausted();
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    friend iterator;
+
+    bool done() const noexcept {
+        return index_ == N;
+    }
+
+    reference get() const {
+        return *it_;
+    }
+
+    void next() {
+        ++it_;
+        skip_exhausted();
+    }
+
+    void skip_exhausted() {
+        while (detail::exhausted<Generator>(it_)) {
+            if (++index_ == N)
+                return;
+            it_ = gens_[index_].begin();
+        }
+    }
+
+    std::array<Generator, N> gens_;
+    typename Generator::iterator it_;
+    std::size_t index_ = N;
+};
+
+// Tuples of the values of all the generators, until one is exhausted.
+template <typename... Generators>
+class zip_view {
+  public:
+    using reference = std::tuple<typename Generators::iterator::reference...>;
+    using iterator = view_iterator<zip_view>;
+
+    explicit zip_view(Generators... gens) : gens_(std::move(gens)...) {
+    }
+
+    zip_view(const zip_view &) = delete;
+    zip_view &operator=(const zip_view &) = delete;
+
+    iterator begin() {
+        std::apply([this](auto &...gens) { its_ = {gens.begin()...}; }, gens_);
+        started_ = true;
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    friend iterator;
+
+    bool done() const noexcept {
+        return !started_ || done(std::index_sequence_for<Generators...>{});
+    }
+    template <std::size_t... I>
+    bool done(std::index_sequence<I...>) const noexcept {
+        return (... || detail::exhausted<Generators>(std::get<I>(its_)));
+    }
+
+    reference get() const {
+        return std::apply([](auto &...its) { return reference(*its...); }, its_);
+    }
+
+    void next() {
+        std::apply([](auto &...its) { (++its, ...); }, its_);
+    }
+
+    std::tuple<Generators...> gens_;
+    std::tuple<typename Generators::iterator...> its_;
+    bool started_ = false;
+};
+
+// Tuples of the index of each value, from 0, and the value.
+template <typename Generator>
+class enumerate_view {
+  public:
+    using reference = std::tuple<std::size_t, typename Generator::iterator::reference>;
+    using iterator = view_iterator<enumerate_view>;
+
+    explicit enumerate_view(Generator gen) : gen_(std::move(gen)) {
+    }
+
+    enumerate_view(const enumerate_view &) = delete;
+    enumerate_view &operator=(const enumerate_view &) = delete;
+
+    iterator begin() {
+        it_ = gen_.begin();
+        index_ = 0;
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    friend iterator;
+
+    bool done() const noexcept {
+        return detail::exhausted<Generator>(it_);
+    }
+
+    reference get() const {
+        return reference(index_, *it_);
+    }
+
+    void next() {
+        ++it_;
+        ++index_;
+    }
+
+    Generator gen_;
+    typename Generator::iterator it_;
+    std::size_t index_ = 0;
+};
+
+// Ranges of `size` consecutive values, the last one possibly shorter.
+// A chunk reads from the generator itself rather than from a copy, so it
+// can only be iterated once, before moving to the next chunk; values left
+// unread in a chunk are skipped.
+template <typename Generator>
+class chunk_view {
+  public:
+    class chunk {
+      public:
+        using reference = typename Generator::iterator::reference;
+        using iterator = view_iterator<chunk>;
+
+        iterator begin() noexcept {
+            return iterator{this};
+        }
+
+        sentinel end() noexcept {
+            return {};
+        }
+
+      private:
+        friend chunk_view;
+        friend iterator;
+        explicit chunk(chunk_view *view) noexcept : view_(view) {
+        }
+
+        bool done() const noexcept {
+            return view_->remaining_ == 0 || detail::exhausted<Generator>(view_->it_);
+        }
+
+        reference get() const {
+            return *view_->it_;
+        }
+
+        void next() {
+            ++view_->it_;
+            --view_->remaining_;
+        }
+
+        chunk_view *view_;
+    };
+
+    using reference = chunk;
+    using iterator = view_iterator<chunk_view>;
+
+    chunk_view(Generator gen, std::size_t size) : gen_(std::move(gen)), size_(size == 0 ? 1 : size) {
+    }
+
+    chunk_view(const chunk_view &) = delete;
+    chunk_view &operator=(const chunk_view &) = delete;
+
+    iterator begin() {
+        it_ = gen_.begin();
+        remaining_ = size_;
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    friend iterator;
+
+    bool done() const noexcept {
+        return detail::exhausted<Generator>(it_);
+    }
+
+    chunk get() noexcept {
+        return chunk{this};
+    }
+
+    void next() {
+        for (; remaining_ != 0 && !detail::exhausted<Generator>(it_); --remaining_)
+            ++it_;
+        remaining_ = size_;
+    }
+
+    Generator gen_;
+    typename Generator::iterator it_;
+    std::size_t size_;
+    std::size_t remaining_ = 0;
+};
+
+// One value of each generator in turn, skipping the exhausted ones.
+template <typename Generator, std::size_t N>
+class interleave_view {
+  public:
+    using reference = typename Generator::iterator::reference;
+    using iterator = view_iterator<interleave_view>;
+
+    explicit interleave_view(std::array<Generator, N> gens) : gens_(std::move(gens)) {
+    }
+
+    interleave_view(const interleave_view &) = delete;
+    interleave_view &operator=(const interleave_view &) = delete;
+
+    iterator begin() {
+        for (std::size_t i = 0; i < N; ++i)
+            its_[i] = gens_[i].begin();
+        index_ = N - 1;
+        advance();
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    friend iterator;
+
+    bool done() const noexcept {
+        return index_ == N;
+    }
+
+    reference get() const {
+        return *its_[index_];
+    }
+
+    void next() {
+        ++its_[index_];
+        advance();
+    }
+
+    // Moves to the next generator with values left, this one last.
+    void advance() {
+        std::size_t i = index_;
+        for (std::size_t step = 0; step < N; ++step) {
+            if (++i == N)
+                i = 0;
+            if (!detail::exhausted<Generator>(its_[i])) {
+                index_ = i;
+                return;
+            }
+        }
+        index_ = N;
+    }
+
+    std::array<Generator, N> gens_;
+    std::array<typename Generator::iterator, N> its_;
+    std::size_t index_ = N;
+};
+
+template <typename Generator, typename... Generators>
+requires(std::same_as<Generator, Generators> &&...) concat_view<Generator, 1 + sizeof...(Generators)> concat(
+    Generator first, Generators... rest) {
+    return concat_view<Generator, 1 + sizeof...(Generators)>({std::move(first), std::move(rest)...});
+}
+
+template <typename... Generators>
+requires(sizeof...(Generators) != 0) zip_view<Generators...> zip(Generators... gens) {
+    return zip_view<Generators...>(std::move(gens)...);
+}
+
+template <typename Generator>
+enumerate_view<Generator> enumerate(Generator gen) {
+    return enumerate_view<Generator>(std::move(gen));
+}
+
+template <typename Generator>
+chunk_view<Generator> chunk(Generator gen, std::size_t size) {
+    return chunk_view<Generator>(std::move(gen), size);
+}
+
+template <typename Generator, typename... Generators>
+requires(std::same_as<Generator, Generators> &&...) interleave_view<Generator, 1 + sizeof...(Generators)> interleave(
+    Generator first, Generators... rest) {
+    return interleave_view<Generator, 1 + sizeof...(Generators)>({std::move(first), std::move(rest)...});
+}
+
+} // namespace combinators
@@ -0,0 +1,230 @@
+////////////////////////////////////////////////////////////////
+// Minimal single-threaded event loop driving coroutines, e.g. the
+// bodies of async::generator, on top of epoll and an eventfd.
+//
+// Linux only.
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Eagerly started coroutine that nobody awaits; its frame is destroyed
+// when it completes. Exceptions escaping it terminate the program.
+struct fire_and_forget {
+    struct promise_type {
+        fire_and_forget get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+class epoll_executor {
+    static void throw_system_error(const char *what) {
+        throw std::system_error(errno, std::system_category(), what);
+    }
+
+  public:
+    epoll_executor() : epoll_(::epoll_create1(EPOLL_CLOEXEC)) {
+        if (epoll_ < 0)
+            throw_system_error("epoll_create1");
+        wakeup_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_ < 0) {
+            ::close(epoll_);
+            throw_system_error("eventfd");
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        ::epoll_ctl(epoll_, EPOLL_CTL_ADD, wakeup_, &ev);
+    }
+
+    epoll_executor(const epoll_executor &) = delete;
+    epoll_executor &operator=(const epoll_executor &) = delete;
+
+    ~epoll_executor() {
+        ::close(wakeup_);
+        ::close(epoll_);
+    }
+
+    // Suspends the awaiting coroutine until the file descriptor is ready.
+    class fd_awaiter {
+      public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle_ = h;
+            executor_.watch(fd_, events_, this);
+        }
+        void await_resume() const noexcept {
+        }
+
+      private:
+        friend epoll_executor;
+        fd_awaiter(epoll_executor &executor, int fd, std::uint32_t events) noexcept
+            : executor_(executor), fd_(fd), events_(events) {
+        }
+
+        epoll_executor &executor_;
+        int fd_;
+        std::uint32_t events_;
+        std::coroutine_handle<> handle_;
+    };
+
+    fd_awaiter readable(int fd) noexcept {
+        return {*this, fd, EPOLLIN};
+    }
+
+    fd_awaiter writable(int fd) noexcept {
+        return {*this, fd, EPOLLOUT};
+    }
+
+    // Reschedules the awaiting coroutine behind the ones already ready.
+    class schedule_awaiter {
+      public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            executor_.ready_.push_back(h);
+        }
+        void await_resume() const noexcept {
+        }
+
+      private:
+        friend epoll_executor;
+        explicit schedule_awaiter(epoll_executor &executor) noexcept
+            : executor_(executor) {
+        }
+
+        epoll_executor &executor_;
+    };
+
+    schedule_awaiter schedule() noexcept {
+        return schedule_awaiter{*this};
+    }
+
+    // Resumes h on the thread running the loop. Can be called from any
+    // thread.
+    void post(std::coroutine_handle<> h) {
+        {
+            std::lock_guard lock(remoteMutex_);
+            remote_.push_back(h);
+        }
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write(wakeup_, &one, sizeof(one));
+    }
+
+    // Stops run() once the coroutines ready to run have been resumed.
+    // Can be called from any thread.
+    void stop() {
+        {
+            std::lock_guard lock(remoteMutex_);
+            stopped_ = true;
+        }
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto n = ::write(wakeup_, &one, sizeof(one));
+    }
+
+    // Runs until stop() is called, or until there is nothing left to
+    // resume: no ready coroutine and no pending fd_awaiter.
+    void run() {
+        epoll_event events[64];
+        for (;;) {
+            while (!ready_.empty()) {
+                auto h = ready_.front();
+                ready_.pop_front();
+                h.resume();
+            }
+            {
+                std::lock_guard lock(remoteMutex_);
+                if (stopped_) {
+                    stopped_ = false;
+                    return;
+                }
+                if (watching_ == 0 && remote_.empty())
+                    return;
+            }
+            const int n = ::epoll_wait(epoll_, events, std::size(events), -1);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw_system_error("epoll_wait");
+            }
+            for (int i = 0; i < n; ++i) {
+                if (auto *awaiter = static_cast<fd_awaiter *>(events[i].data.ptr)) {
+                    --watching_;
+                    ready_.push_back(awaiter->handle_);
+                } else {
+                    drain_remote();
+                }
+            }
+        }
+    }
+
+  private:
+    void watch(int fd, std::uint32_t events, fd_awaiter *awaiter) {
+        if (std::size_t(fd) >= registered_.size())
+            registered_.resize(fd + 1);
+        epoll_event ev{};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.ptr = awaiter;
+        // A descriptor stays registered once watched; a closed and reused
+        // descriptor number is no longer known to epoll and is added again.
+        int result = -1;
+        if (registered_[fd])
+            result = ::epoll_ctl(epoll_, EPOLL_CTL_MOD, fd, &ev);
+        if (result < 0) {
+            if (::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev) < 0)
+                throw_system_error("epoll_ctl");
+            registered_[fd] = true;
+        }
+        ++watching_;
+    }
+
+    void drain_remote() {
+        std::uint64_t count;
+        [[maybe_unused]] auto n = ::read(wakeup_, &count, sizeof(count));
+        std::lock_guard lock(remoteMutex_);
+        for (auto h : remote_)
+            ready_.push_back(h);
+        remote_.clear();
+    }
+
+    int epoll_ = -1;
+    int wakeup_ = -1;
+    std::size_t watching_ = 0;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::vector<bool> registered_;
+
+    std::mutex remoteMutex_;
+    std::vector<std::coroutine_handle<>> remote_;
+    bool stopped_ = false;
+};
+
+#endif
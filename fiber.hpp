@@ -0,0 +1,321 @@
+////////////////////////////////////////////////////////////////
+// Stackful generators, as a baseline for the stackless coroutines of
+// generator.hpp.
+//
+// A fiber_generator runs a function on a stack of its own. The function
+// yields values by calling the yielder it is passed, from any depth of
+// nested calls, which switches back to the consumer.
+//
+// On x86-64 with GCC or Clang, the switch is a small routine saving the
+// callee-saved registers and swapping stack pointers. On other POSIX
+// systems it goes through ucontext, whose swapcontext() also saves and
+// restores the signal mask with a system call. FIBER_GENERATOR_SUPPORTED
+// is defined when either is available.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FIBER_GENERATOR_SUPPORTED 1
+#define FIBER_GENERATOR_SWITCH 1
+#elif defined(__unix__) || defined(__APPLE__)
+#define FIBER_GENERATOR_SUPPORTED 1
+#include <ucontext.h>
+#endif
+
+#if defined(FIBER_GENERATOR_SUPPORTED)
+
+#if defined(FIBER_GENERATOR_SWITCH)
+// Saves the callee-saved registers on the current stack, stores the stack
+// pointer in *save, then restores the registers from the stack at `load`
+// and returns there. The return is an indirect jump rather than a ret,
+// which would always miss in the return stack buffer.
+[[gnu::naked, gnu::noinline]] inline void __fiber_switch(void ** /*save*/, void * /*load*/) noexcept {
+    asm("pushq %rbp\n\t"
+        "pushq %rbx\n\t"
+        "pushq %r12\n\t"
+        "pushq %r13\n\t"
+        "pushq %r14\n\t"
+        "pushq %r15\n\t"
+        "movq %rsp, (%rdi)\n\t"
+        "movq %rsi, %rsp\n\t"
+        "popq %r15\n\t"
+        "popq %r14\n\t"
+        "popq %r13\n\t"
+        "popq %r12\n\t"
+        "popq %rbx\n\t"
+        "popq %rbp\n\t"
+        "popq %rax\n\t"
+        "jmpq *%rax\n\t");
+}
+
+// First return address of a fiber: calls entry(arg), both left in
+// callee-saved registers by __fiber_context::start(). The entry never
+// returns.
+[[gnu::naked, gnu::noinline]] inline void __fiber_trampoline() noexcept {
+    asm("movq %rbx, %rdi\n\t"
+        "callq *%r12\n\t"
+        "ud2\n\t");
+}
+#endif
+
+// Execution context of a fiber, and of the consumer switching to it.
+class __fiber_context {
+  public:
+    using entry_type = void (*)(void *);
+
+    // Prepares entry(arg) to run on the given stack at the first
+    // switch_in(). The entry must not return.
+    void start(std::byte *stack, std::size_t size, entry_type entry, void *arg) noexcept {
+#if defined(FIBER_GENERATOR_SWITCH)
+        const auto top = (reinterpret_cast<std::uintptr_t>(stack) + size) & ~std::uintptr_t(15);
+        // r15, r14, r13, r12, rbx, rbp and return address, so that the
+        // stack is 16-byte aligned once the return address is popped.
+        void **sp = reinterpret_cast<void **>(top - 16) - 7;
+        sp[0] = sp[1] = sp[2] = nullptr;
+        sp[3] = reinterpret_cast<void *>(entry);
+        sp[4] = arg;
+        sp[5] = nullptr;
+        sp[6] = reinterpret_cast<void *>(&__fiber_trampoline);
+        fiber_ = sp;
+#else
+        entry_ = entry;
+        arg_ = arg;
+        ::getcontext(&fiber_);
+        fiber_.uc_stack.ss_sp = stack;
+        fiber_.uc_stack.ss_size = size;
+        fiber_.uc_link = nullptr;
+        // makecontext() only passes ints.
+        const auto self = reinterpret_cast<std::uintptr_t>(this);
+        ::makecontext(&fiber_, reinterpret_cast<void (*)()>(&run), 2,
+                      unsigned(std::uint64_t(self) >> 32), unsigned(self));
+#endif
+    }
+
+    // From the consumer to the fiber.
+    void switch_in() noexcept {
+#if defined(FIBER_GENERATOR_SWITCH)
+        __fiber_switch(&consumer_, fiber_);
+#else
+        ::swapcontext(&consumer_, &fiber_);
+#endif
+    }
+
+    // From the fiber back to the consumer.
+    void switch_out() noexcept {
+#if defined(FIBER_GENERATOR_SWITCH)
+        __fiber_switch(&fiber_, consumer_);
+#else
+        ::swapcontext(&fiber_, &consumer_);
+#endif
+    }
+
+  private:
+#if defined(FIBER_GENERATOR_SWITCH)
+    void *fiber_ = nullptr;
+    void *consumer_ = nullptr;
+#else
+    static void run(unsigned high, unsigned low) {
+        const auto self = std::uintptr_t((std::uint64_t(high) << 32) | low);
+        auto &context = *reinterpret_cast<__fiber_context *>(self);
+        context.entry_(context.arg_);
+    }
+
+    entry_type entry_ = nullptr;
+    void *arg_ = nullptr;
+    ucontext_t fiber_;
+    ucontext_t consumer_;
+#endif
+};
+
+// Stack of a fiber. Where mmap() is available, the stack is mapped with
+// an inaccessible guard page below it, so that an overflow faults instead
+// of writing over the heap, and its pages are only committed as the
+// fiber touches them.
+class __fiber_stack {
+  public:
+    explicit __fiber_stack(std::size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+        const auto page = std::size_t(::sysconf(_SC_PAGESIZE));
+        size_ = (size + page - 1) / page * page;
+        mapped_ = size_ + page;
+        void *p = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        if (::mprotect(p, page, PROT_NONE) != 0) {
+            ::munmap(p, mapped_);
+            throw std::bad_alloc();
+        }
+        base_ = static_cast<std::byte *>(p);
+        stack_ = base_ + page;
+#else
+        size_ = size;
+        base_ = stack_ = new std::byte[size];
+#endif
+    }
+
+    __fiber_stack(const __fiber_stack &) = delete;
+    __fiber_stack &operator=(const __fiber_stack &) = delete;
+
+    ~__fiber_stack() {
+#if defined(__unix__) || defined(__APPLE__)
+        ::munmap(base_, mapped_);
+#else
+        delete[] base_;
+#endif
+    }
+
+    std::byte *data() const noexcept {
+        return stack_;
+    }
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+  private:
+    std::byte *base_ = nullptr;
+    std::byte *stack_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t mapped_ = 0;
+};
+
+template <typename T>
+class fiber_generator {
+    // Thrown out of the yielder to unwind a fiber destroyed early.
+    struct cancelled {};
+
+  public:
+    static constexpr std::size_t default_stack_size = std::size_t(64) << 10;
+
+    class yielder {
+      public:
+        void operator()(const T &value) {
+            gen_.value_ = std::addressof(value);
+            gen_.context_.switch_out();
+            if (gen_.cancelled_)
+                throw cancelled{};
+        }
+
+      private:
+        friend fiber_generator;
+        explicit yielder(fiber_generator &gen) noexcept : gen_(gen) {
+        }
+
+        fiber_generator &gen_;
+    };
+
+    // `body(yield)` runs on the fiber's own stack, which must be large
+    // enough for the deepest recursion of the body: overflowing it faults
+    // on the guard page, where there is one.
+    template <typename F>
+    explicit fiber_generator(F body, std::size_t stackSize = default_stack_size)
+        : body_(std::move(body)), stack_(stackSize) {
+        context_.start(stack_.data(), stack_.size(), &run, this);
+    }
+
+    // The fiber's stack refers to the generator.
+    fiber_generator(const fiber_generator &) = delete;
+    fiber_generator &operator=(const fiber_generator &) = delete;
+
+    // Unwinds the body of a fiber suspended in a yield.
+    ~fiber_generator() {
+        if (started_ && !done_) {
+            cancelled_ = true;
+            context_.switch_in();
+        }
+    }
+
+    struct sentinel {};
+
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = const T &;
+        using pointer = const T *;
+
+        iterator() noexcept = default;
+
+        friend bool operator==(const iterator &it, sentinel) noexcept {
+            return it.done();
+        }
+
+        iterator &operator++() {
+            gen_->resume();
+            return *this;
+        }
+        void operator++(int) {
+            (void)operator++();
+        }
+
+        reference operator*() const noexcept {
+            return *gen_->value_;
+        }
+
+      private:
+        friend fiber_generator;
+        explicit iterator(fiber_generator *gen) noexcept : gen_(gen) {
+        }
+
+        bool done() const noexcept {
+            return !gen_ || gen_->done_;
+        }
+
+        fiber_generator *gen_ = nullptr;
+    };
+
+    iterator begin() {
+        resume();
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    static void run(void *arg) {
+        auto &self = *static_cast<fiber_generator *>(arg);
+        try {
+            yielder yield(self);
+            self.body_(yield);
+        } catch (const cancelled &) {
+        } catch (...) {
+            self.exception_ = std::current_exception();
+        }
+        self.done_ = true;
+        self.context_.switch_out();
+    }
+
+    void resume() {
+        started_ = true;
+        context_.switch_in();
+        if (exception_)
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+
+    std::function<void(yielder &)> body_;
+    __fiber_stack stack_;
+    __fiber_context context_;
+    const T *value_ = nullptr;
+    std::exception_ptr exception_;
+    bool started_ = false;
+    bool done_ = false;
+    bool cancelled_ = false;
+};
+
+#endif
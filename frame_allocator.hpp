@@ -0,0 +1,477 @@
+////////////////////////////////////////////////////////////////
+// Allocators for coroutine frames.
+//
+// These plug into promise_base_type<Alloc> through the Alloc
+// template parameter of simple::generator and recursive::generator.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace frame_pool {
+
+// Frames are rounded up to a multiple of size_class_granularity and
+// recycled through one free list per class. Frames larger than
+// max_pooled_frame_size always go to the global heap.
+inline constexpr std::size_t size_class_granularity = 64;
+inline constexpr std::size_t size_class_count = 16;
+inline constexpr std::size_t max_pooled_frame_size =
+    size_class_granularity * size_class_count;
+
+// Upper bound on the number of idle frames kept per size class and thread.
+// Frames freed beyond that bound are returned to the global heap.
+inline constexpr std::size_t max_cached_frames = 256;
+
+constexpr std::size_t size_class(std::size_t size) noexcept {
+    return (size - 1) / size_class_granularity;
+}
+
+constexpr std::size_t class_size(std::size_t sizeClass) noexcept {
+    return (sizeClass + 1) * size_class_granularity;
+}
+
+class thread_cache {
+    struct free_block {
+        free_block *next_;
+    };
+
+    struct bucket {
+        free_block *head_ = nullptr;
+        std::size_t count_ = 0;
+    };
+
+  public:
+    thread_cache() noexcept = default;
+    thread_cache(const thread_cache &) = delete;
+    thread_cache &operator=(const thread_cache &) = delete;
+
+    ~thread_cache() {
+        for (std::size_t c = 0; c < size_class_count; ++c) {
+            while (free_block *block = buckets_[c].head_) {
+                buckets_[c].head_ = block->next_;
+                ::operator delete(static_cast<void *>(block), class_size(c));
+            }
+        }
+    }
+
+    void *allocate(std::size_t size) {
+        if (size > max_pooled_frame_size || size == 0)
+            return ::operator new(size);
+        bucket &b = buckets_[size_class(size)];
+        if (free_block *block = b.head_) {
+            b.head_ = block->next_;
+            --b.count_;
+            return block;
+        }
+        return ::operator new(class_size(size_class(size)));
+    }
+
+    void deallocate(void *ptr, std::size_t size) noexcept {
+        if (size > max_pooled_frame_size || size == 0) {
+            ::operator delete(ptr, size);
+            return;
+        }
+        const std::size_t sizeClass = size_class(size);
+        bucket &b = buckets_[sizeClass];
+        if (b.count_ == max_cached_frames) {
+            ::operator delete(ptr, class_size(sizeClass));
+            return;
+        }
+        b.head_ = ::new (ptr) free_block{b.head_};
+        ++b.count_;
+    }
+
+    std::size_t cached_frames() const noexcept {
+        std::size_t n = 0;
+        for (const bucket &b : buckets_)
+            n += b.count_;
+        return n;
+    }
+
+    static thread_cache &local() noexcept {
+        thread_local thread_cache cache;
+        return cache;
+    }
+
+  private:
+    bucket buckets_[size_class_count];
+};
+
+} // namespace frame_pool
+
+// Stateless allocator recycling frames through frame_pool::thread_cache.
+//
+// A frame may be freed on a different thread than the one that allocated
+// it; it then simply joins the free list of the freeing thread.
+template <typename T = std::byte>
+class pooled_frame_allocator {
+  public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    pooled_frame_allocator() noexcept = default;
+
+    template <typename U>
+    pooled_frame_allocator(const pooled_frame_allocator<U> &) noexcept {
+    }
+
+    T *allocate(std::size_t n) {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        return static_cast<T *>(
+            frame_pool::thread_cache::local().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        frame_pool::thread_cache::local().deallocate(p, n * sizeof(T));
+    }
+
+    friend bool operator==(const pooled_frame_allocator &,
+                           const pooled_frame_allocator &) noexcept {
+        return true;
+    }
+};
+
+// Stack arena for frames whose lifetimes nest.
+//
+// recursive::generator's yield_sequence_awaiter owns the nested generator,
+// so a child frame is always destroyed before the frame that created it.
+// The arena exploits that: frames are bump-allocated from contiguous chunks
+// and deallocation pops the top of the stack. Deallocating anything but the
+// most recent live frame is a logic error.
+//
+// Chunks are retained until the arena is destroyed. They are obtained from
+// mmap when huge pages are requested (explicit huge pages if the system has
+// some reserved, transparent huge pages otherwise), and from the global heap
+// otherwise.
+class frame_arena {
+    struct chunk {
+        chunk *prev_;
+        std::byte *prevTop_; // top of prev_ when this chunk was pushed
+        std::size_t size_;   // total size, header included
+        bool mapped_;
+
+        std::byte *begin() noexcept {
+            return reinterpret_cast<std::byte *>(this) + header_size;
+        }
+        std::byte *end() noexcept {
+            return reinterpret_cast<std::byte *>(this) + size_;
+        }
+    };
+
+  public:
+    static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    explicit frame_arena(std::size_t chunkSize = huge_page_size,
+                         bool hugePages = false) noexcept
+        : chunkSize_(chunkSize), hugePages_(hugePages) {
+    }
+
+    frame_arena(const frame_arena &) = delete;
+    frame_arena &operator=(const frame_arena &) = delete;
+
+    ~frame_arena() {
+        assert(empty());
+        while (current_) {
+            chunk *prev = current_->prev_;
+            release(current_);
+            current_ = prev;
+        }
+        while (spare_) {
+            chunk *next = spare_->prev_;
+            release(spare_);
+            spare_ = next;
+        }
+    }
+
+    void *allocate(std::size_t size) {
+        size = round_up(size);
+        if (!current_ || std::size_t(current_->end() - top_) < size)
+            push_chunk(size);
+        void *p = top_;
+        top_ += size;
+        return p;
+    }
+
+    void deallocate(void *p, std::size_t size) noexcept {
+        size = round_up(size);
+        assert(static_cast<std::byte *>(p) + size == top_ &&
+               "frame_arena deallocation out of LIFO order");
+        top_ = static_cast<std::byte *>(p);
+        if (top_ == current_->begin() && current_->prev_)
+            pop_chunk();
+    }
+
+    bool empty() const noexcept {
+        return !current_ || (!current_->prev_ && top_ == current_->begin());
+    }
+
+  private:
+    static constexpr std::size_t header_size =
+        (sizeof(chunk) + alignment - 1) & ~(alignment - 1);
+
+    static constexpr std::size_t round_up(std::size_t size) noexcept {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    void push_chunk(std::size_t size) {
+        chunk *c = nullptr;
+        if (spare_ && std::size_t(spare_->end() - spare_->begin()) >= size) {
+            c = std::exchange(spare_, spare_->prev_);
+        } else {
+            std::size_t bytes = chunkSize_;
+            if (bytes < size + header_size)
+                bytes = size + header_size;
+            c = acquire(bytes);
+        }
+        c->prev_ = current_;
+        c->prevTop_ = top_;
+        current_ = c;
+        top_ = c->begin();
+    }
+
+    void pop_chunk() noexcept {
+        chunk *c = current_;
+        current_ = c->prev_;
+        top_ = c->prevTop_;
+        // Emptied chunks are kept until the arena is destroyed, so that
+        // recursions reusing the arena do not map and unmap memory.
+        c->prev_ = spare_;
+        spare_ = c;
+    }
+
+    chunk *acquire(std::size_t bytes) {
+#if defined(__linux__)
+        if (hugePages_) {
+            bytes = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+            void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED)
+                    throw std::bad_alloc();
+                ::madvise(p, bytes, MADV_HUGEPAGE);
+            }
+            return ::new (p) chunk{nullptr, nullptr, bytes, true};
+        }
+#endif
+        return ::new (::operator new(bytes)) chunk{nullptr, nullptr, bytes, false};
+    }
+
+    static void release(chunk *c) noexcept {
+#if defined(__linux__)
+        if (c->mapped_) {
+            ::munmap(c, c->size_);
+            return;
+        }
+#endif
+        ::operator delete(c, c->size_);
+    }
+
+    chunk *current_ = nullptr;
+    chunk *spare_ = nullptr;
+    std::byte *top_ = nullptr;
+    std::size_t chunkSize_;
+    bool hugePages_;
+};
+
+// Allocator handle to a frame_arena. It is stateful, so generators using it
+// must be invoked with std::allocator_arg as their first argument(s); the
+// handle is then stored at the end of each frame by promise_base_type.
+template <typename T = std::byte>
+class frame_arena_allocator {
+  public:
+    using value_type = T;
+
+    explicit frame_arena_allocator(frame_arena &arena) noexcept
+        : arena_(&arena) {
+    }
+
+    template <typename U>
+    frame_arena_allocator(const frame_arena_allocator<U> &other) noexcept
+        : arena_(other.arena_) {
+    }
+
+    T *allocate(std::size_t n) {
+        static_assert(alignof(T) <= frame_arena::alignment);
+        return static_cast<T *>(arena_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        arena_->deallocate(p, n * sizeof(T));
+    }
+
+    friend bool operator==(const frame_arena_allocator &a,
+                           const frame_arena_allocator &b) noexcept {
+        return a.arena_ == b.arena_;
+    }
+
+  private:
+    template <typename U>
+    friend class frame_arena_allocator;
+
+    frame_arena *arena_;
+};
+
+// Stateless allocator bump-allocating frames from a frame_arena of the
+// calling thread, with the same LIFO requirement: each frame must be freed
+// on the thread that allocated it, after all the frames allocated after
+// it. Frames of recursive::generator trees, and of generators consumed
+// one at a time, qualify; generators passed to other threads (read_ahead,
+// parallel_traverse) or kept alive out of order do not.
+template <typename T = std::byte>
+class thread_arena_allocator {
+  public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    thread_arena_allocator() noexcept = default;
+
+    template <typename U>
+    thread_arena_allocator(const thread_arena_allocator<U> &) noexcept {
+    }
+
+    T *allocate(std::size_t n) {
+        static_assert(alignof(T) <= frame_arena::alignment);
+        return static_cast<T *>(arena().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        arena().deallocate(p, n * sizeof(T));
+    }
+
+    friend bool operator==(const thread_arena_allocator &,
+                           const thread_arena_allocator &) noexcept {
+        return true;
+    }
+
+  private:
+    static frame_arena &arena() noexcept {
+        static thread_local frame_arena local;
+        return local;
+    }
+};
+
+// Caller-provided storage for one coroutine frame at a time, typically on
+// the stack of the consumer or embedded in an object, so that generators
+// allocated from it never touch the heap.
+//
+// The frame size is only known when the frame is allocated, so whether it
+// fits is checked then: a frame larger than the storage, or requested while
+// the storage already holds a frame, falls back to the global heap. Such
+// fallbacks are counted, and the largest size requested is recorded to help
+// sizing the storage.
+class frame_buffer {
+  public:
+    static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    frame_buffer(void *data, std::size_t size) noexcept : data_(data), size_(size) {
+    }
+
+    frame_buffer(const frame_buffer &) = delete;
+    frame_buffer &operator=(const frame_buffer &) = delete;
+
+    ~frame_buffer() {
+        assert(!inUse_);
+    }
+
+    void *allocate(std::size_t size) {
+        if (size > largestRequest_)
+            largestRequest_ = size;
+        if (inUse_ || size > size_) {
+            ++fallbacks_;
+            return ::operator new(size);
+        }
+        inUse_ = true;
+        return data_;
+    }
+
+    void deallocate(void *p, std::size_t size) noexcept {
+        if (p == data_) {
+            inUse_ = false;
+            return;
+        }
+        ::operator delete(p, size);
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    // Number of frames that went to the heap.
+    std::size_t fallbacks() const noexcept {
+        return fallbacks_;
+    }
+
+    // Size of the largest frame requested, including the allocator handle
+    // promise_base_type stores after it.
+    std::size_t largest_request() const noexcept {
+        return largestRequest_;
+    }
+
+  private:
+    void *data_;
+    std::size_t size_;
+    bool inUse_ = false;
+    std::size_t fallbacks_ = 0;
+    std::size_t largestRequest_ = 0;
+};
+
+// frame_buffer with its own Size bytes of storage.
+template <std::size_t Size>
+class inline_frame_buffer : public frame_buffer {
+  public:
+    inline_frame_buffer() noexcept : frame_buffer(storage_, Size) {
+    }
+
+  private:
+    alignas(frame_buffer::alignment) std::byte storage_[Size];
+};
+
+// Allocator handle to a frame_buffer. Like frame_arena_allocator, it is
+// stateful: generators using it take std::allocator_arg and the handle as
+// their first arguments.
+template <typename T = std::byte>
+class inline_frame_allocator {
+  public:
+    using value_type = T;
+
+    explicit inline_frame_allocator(frame_buffer &buffer) noexcept
+        : buffer_(&buffer) {
+    }
+
+    template <typename U>
+    inline_frame_allocator(const inline_frame_allocator<U> &other) noexcept
+        : buffer_(other.buffer_) {
+    }
+
+    T *allocate(std::size_t n) {
+        static_assert(alignof(T) <= frame_buffer::alignment);
+        return static_cast<T *>(buffer_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        buffer_->deallocate(p, n * sizeof(T));
+    }
+
+    friend bool operator==(const inline_frame_allocator &a,
+                           const inline_frame_allocator &b) noexcept {
+        return a.buffer_ == b.buffer_;
+    }
+
+  private:
+    template <typename U>
+    friend class inline_frame_allocator;
+
+    frame_buffer *buffer_;
+};
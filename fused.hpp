@@ -0,0 +1,262 @@
+////////////////////////////////////////////////////////////////
+// Range adaptors fused into the producer side of a generator.
+//
+//   for (auto &&v : gen | fused::transform(f) | fused::filter(p) | fused::take(n))
+//
+// The stages run in the generator's promise, through set_yield_filter(),
+// right where values are yielded. Values rejected by a filter never
+// resume the consumer, so that each consumed value costs one resumption
+// however many stages the pipeline has. Stages are stateless function
+// objects, apart from the count of take().
+//
+// Works with simple::generator and recursive::generator whose policy has
+// filter_policy::filtered.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fused {
+
+template <typename F>
+struct transform_stage {
+    F f_;
+};
+
+template <typename P>
+struct filter_stage {
+    P pred_;
+};
+
+struct take_stage {
+    std::size_t count_;
+};
+
+template <typename F>
+transform_stage<std::decay_t<F>> transform(F &&f) {
+    return {std::forward<F>(f)};
+}
+
+template <typename P>
+filter_stage<std::decay_t<P>> filter(P &&pred) {
+    return {std::forward<P>(pred)};
+}
+
+inline take_stage take(std::size_t count) noexcept {
+    return {count};
+}
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool is_stage = false;
+template <typename F>
+inline constexpr bool is_stage<transform_stage<F>> = true;
+template <typename P>
+inline constexpr bool is_stage<filter_stage<P>> = true;
+template <>
+inline constexpr bool is_stage<take_stage> = true;
+
+template <typename T>
+concept stage = is_stage<T>;
+
+// Type of the values flowing out of the stages, given the type T flowing in.
+template <typename T, typename... Stages>
+struct output {
+    using type = T;
+};
+
+template <typename T, typename F, typename... Stages>
+struct output<T, transform_stage<F>, Stages...>
+    : output<std::invoke_result_t<const F &, T>, Stages...> {};
+
+template <typename T, typename P, typename... Stages>
+struct output<T, filter_stage<P>, Stages...> : output<T, Stages...> {};
+
+template <typename T, typename... Stages>
+struct output<T, take_stage, Stages...> : output<T, Stages...> {};
+
+} // namespace detail
+
+template <typename Generator, typename... Stages>
+class view {
+    using input = typename Generator::iterator::reference;
+    using output = typename detail::output<input &&, Stages...>::type;
+
+  public:
+    view(Generator gen, std::tuple<Stages...> stages)
+        : gen_(std::move(gen)), stages_(std::move(stages)) {
+    }
+
+    // The generator keeps a pointer to the view once iteration started.
+    view(const view &) = delete;
+    view &operator=(const view &) = delete;
+
+    ~view() {
+        if (ready_)
+            slot_.destruct();
+    }
+
+    struct sentinel {};
+
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cvref_t<output>;
+        using reference = output;
+
+        iterator() noexcept = default;
+        iterator(const iterator &) = delete;
+
+        iterator(iterator &&o) noexcept : view_(std::exchange(o.view_, {})) {
+        }
+
+        iterator &operator=(iterator &&o) noexcept {
+            std::swap(view_, o.view_);
+            return *this;
+        }
+
+        friend bool operator==(const iterator &it, sentinel) noexcept {
+            return it.done();
+        }
+
+        iterator &operator++() {
+            view_->next();
+            return *this;
+        }
+        void operator++(int) {
+            (void)operator++();
+        }
+
+        reference operator*() const noexcept {
+            return static_cast<reference>(view_->slot_.get());
+        }
+
+      private:
+        friend view;
+        explicit iterator(view *v) noexcept : view_(v) {
+        }
+
+        bool done() const noexcept {
+            return !view_ || !view_->ready_;
+        }
+
+        view *view_ = nullptr;
+    };
+
+    iterator begin() {
+        if (!exhausted_) {
+            gen_.set_yield_filter(&view::accept, this);
+            it_ = gen_.begin();
+            rethrow_stage_exception();
+        }
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+    template <detail::stage Stage>
+    friend view<Generator, Stages..., Stage> operator|(view &&v, Stage stage) {
+        return {std::move(v.gen_),
+                std::tuple_cat(std::move(v.stages_), std::tuple<Stage>(std::move(stage)))};
+    }
+
+  private:
+    // Called by the generator with each yielded value. An exception thrown
+    // by a stage stops the generator, and is rethrown to the consumer.
+    static bool accept(void *context, input &&value) noexcept {
+        view &self = *static_cast<view *>(context);
+        try {
+            return self.template push<0>(static_cast<input &&>(value)) || self.exhausted_;
+        } catch (...) {
+            self.exception_ = std::current_exception();
+            self.exhausted_ = true;
+            return true;
+        }
+    }
+
+    void rethrow_stage_exception() {
+        if (exception_)
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+
+    template <std::size_t I, typename T>
+    bool push(T &&value) {
+        if constexpr (I == sizeof...(Stages)) {
+            slot_.construct(std::forward<T>(value));
+            ready_ = true;
+            return true;
+        } else {
+            auto &stage = std::get<I>(stages_);
+            using stage_type = std::remove_cvref_t<decltype(stage)>;
+            if constexpr (std::is_same_v<stage_type, take_stage>) {
+                if (++taken_[I] == stage.count_)
+                    exhausted_ = true;
+                return push<I + 1>(std::forward<T>(value));
+            } else if constexpr (requires { stage.pred_; }) {
+                if (!std::invoke(stage.pred_, std::as_const(value)))
+                    return false;
+                return push<I + 1>(std::forward<T>(value));
+            } else {
+                return push<I + 1>(std::invoke(std::as_const(stage.f_), std::forward<T>(value)));
+            }
+        }
+    }
+
+    void next() {
+        slot_.destruct();
+        ready_ = false;
+        if (!exhausted_) {
+            ++it_;
+            rethrow_stage_exception();
+        }
+    }
+
+    // A take(0) stage stops the pipeline before it starts.
+    static bool empty_take(const take_stage &stage) noexcept {
+        return stage.count_ == 0;
+    }
+    template <typename Stage>
+    static bool empty_take(const Stage &) noexcept {
+        return false;
+    }
+    static bool starts_exhausted(const std::tuple<Stages...> &stages) noexcept {
+        return std::apply([](const auto &...stage) { return (false || ... || empty_take(stage)); },
+                          stages);
+    }
+
+    Generator gen_;
+    std::tuple<Stages...> stages_;
+    typename Generator::iterator it_;
+    __manual_lifetime<output> slot_;
+    std::array<std::size_t, sizeof...(Stages)> taken_ = {};
+    std::exception_ptr exception_;
+    bool ready_ = false;
+    bool exhausted_ = starts_exhausted(stages_);
+};
+
+template <typename Ref, typename Value, typename Alloc, typename Policy, detail::stage Stage>
+view<simple::generator<Ref, Value, Alloc, Policy>, Stage>
+operator|(simple::generator<Ref, Value, Alloc, Policy> &&gen, Stage stage) {
+    return {std::move(gen), std::tuple<Stage>(std::move(stage))};
+}
+
+template <typename Ref, typename Value, typename Alloc, typename Policy, detail::stage Stage>
+view<recursive::generator<Ref, Value, Alloc, Policy>, Stage>
+operator|(recursive::generator<Ref, Value, Alloc, Policy> &&gen, Stage stage) {
+    return {std::move(gen), std::tuple<Stage>(std::move(stage))};
+}
+
+} // namespace fused
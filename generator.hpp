@@ -8,6 +8,8 @@
 // as the elements of that range are convertible to the current
 // generator's reference type.
 
+#pragma once
+
 #if __has_include(<coroutine>)
 #include <coroutine>
 #else
@@ -20,13 +22,25 @@ using std::experimental::suspend_never;
 } // namespace std
 #endif
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iterator>
+#include <memory>
 #include <new>
+#include <ranges>
+#include <span>
+#include <tuple>
 #include <type_traits>
 #include <utility>
-//#include <ranges>
+#include <vector>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 template <typename T>
 class __manual_lifetime {
@@ -151,6 +165,54 @@ struct elements_of {
 template <typename R>
 elements_of(R &&) -> elements_of<R>;
 
+// Constructor arguments of a value to yield, for the value to be built
+// directly in the generator's slot: co_yield construct_in_place(args...).
+// The arguments are taken by reference; temporaries among them live until
+// the end of the co_yield expression.
+template <typename... Args>
+struct __construct_in_place {
+    std::tuple<Args &&...> args_;
+};
+
+template <typename... Args>
+__construct_in_place<Args...> construct_in_place(Args &&...args) noexcept {
+    return {std::forward_as_tuple((Args &&) args...)};
+}
+
+// Number of values a generator expects to yield from there on, for
+// drain_into() to reserve room ahead: co_yield size_hint{n}. Yielding a
+// hint does not suspend the coroutine, and successive hints add up.
+// Generators without block_policy::blocks ignore hints.
+struct size_hint {
+    std::size_t count;
+};
+
+// Makes room for `count` more elements in `out`, if it can reserve. The
+// capacity at least doubles, so that many small hints do not turn the
+// insertions quadratic.
+template <typename Container>
+void __reserve_hint(Container &out, std::size_t count) {
+    if constexpr (requires { out.reserve(count); out.capacity(); }) {
+        const std::size_t needed = out.size() + count;
+        if (needed > out.capacity())
+            out.reserve(needed > 2 * out.capacity() ? needed : 2 * out.capacity());
+    }
+}
+
+// Awaiter suspending unless the yielded value turned out to be empty,
+// e.g. when yielding an empty block.
+struct __suspend_if {
+    bool suspend_;
+
+    bool await_ready() const noexcept {
+        return !suspend_;
+    }
+    void await_suspend(std::coroutine_handle<>) const noexcept {
+    }
+    void await_resume() const noexcept {
+    }
+};
+
 template <typename Alloc>
 static constexpr bool allocator_needs_to_be_stored =
     !std::allocator_traits<Alloc>::is_always_equal::value ||
@@ -161,6 +223,60 @@ constexpr size_t aligned_allocation_size(size_t s, size_t a) {
     return (s + a - 1) & ~(a - 1);
 }
 
+#if defined(GENERATOR_COUNT_FRAMES)
+// Coroutine frames allocated by the calling thread through
+// promise_base_type, for instrumentation. Frames whose allocation was
+// elided by the compiler never show up here.
+struct frame_counts {
+    // Distinct frame sizes recorded, roughly one per generator function.
+    static constexpr std::size_t max_sizes = 32;
+
+    std::size_t frames = 0;
+    std::size_t bytes = 0;
+    std::size_t live = 0;
+    std::size_t sizes[max_sizes] = {};
+    std::size_t counts[max_sizes] = {};
+    // Frames of the sizes that did not fit in the table.
+    std::size_t others = 0;
+
+    void allocated(std::size_t frameSize) noexcept {
+        ++frames;
+        ++live;
+        bytes += frameSize;
+        for (std::size_t i = 0; i < max_sizes; ++i) {
+            if (counts[i] == 0)
+                sizes[i] = frameSize;
+            if (sizes[i] == frameSize) {
+                ++counts[i];
+                return;
+            }
+        }
+        ++others;
+    }
+
+    void deallocated() noexcept {
+        --live;
+    }
+
+    static frame_counts &local() noexcept {
+        static thread_local frame_counts counts;
+        return counts;
+    }
+};
+#endif
+
+inline void __frame_allocated([[maybe_unused]] std::size_t frameSize) noexcept {
+#if defined(GENERATOR_COUNT_FRAMES)
+    frame_counts::local().allocated(frameSize);
+#endif
+}
+
+inline void __frame_deallocated() noexcept {
+#if defined(GENERATOR_COUNT_FRAMES)
+    frame_counts::local().deallocated();
+#endif
+}
+
 template<typename Alloc = std::allocator<std::byte>>
 class promise_base_type;
 
@@ -185,12 +301,13 @@ public:
     template<typename... Args>
     static void* operator new(std::size_t frameSize, std::allocator_arg_t, Alloc& alloc, Args&...) {
         char_allocator localAlloc(alloc);
-        void* frame = alloc.allocate(padded_frame_size(frameSize));
+        void* frame = localAlloc.allocate(padded_frame_size(frameSize));
 
         // Store allocator at end of the coroutine frame.
         // Assuming the allocator's move constructor is non-throwing (a requirement for allocators)
         ::new (static_cast<void*>(std::addressof(get_allocator(frame, frameSize)))) char_allocator(std::move(localAlloc));
 
+        __frame_allocated(frameSize);
         return frame;
     }
 
@@ -203,7 +320,8 @@ public:
         char_allocator& alloc = get_allocator(ptr, frameSize);
         char_allocator localAlloc(std::move(alloc));
         alloc.~char_allocator();
-        localAlloc.deallocate(static_cast<char*>(ptr), padded_frame_size(frameSize));
+        localAlloc.deallocate(static_cast<std::byte*>(ptr), padded_frame_size(frameSize));
+        __frame_deallocated();
     }
 };
 
@@ -214,20 +332,213 @@ class promise_base_type<Alloc> {
 public:
     static void* operator new(std::size_t size) {
         char_allocator alloc;
-        return alloc.allocate(size);
+        void* frame = alloc.allocate(size);
+        __frame_allocated(size);
+        return frame;
     }
 
     static void operator delete(void* ptr, std::size_t size) {
         char_allocator alloc;
         alloc.deallocate(static_cast<char*>(ptr), size);
+        __frame_deallocated();
+    }
+};
+
+// Configuration of simple::generator and recursive::generator, through
+// their Policy template parameter.
+enum class exception_policy {
+    // Exceptions escaping the coroutine are rethrown to the consumer.
+    propagate,
+    // Exceptions escaping the coroutine call std::terminate(); nothing is
+    // kept to carry them across nested generators.
+    terminate,
+};
+
+enum class start_policy {
+    // The body starts running in begin().
+    lazy,
+    // The body runs up to its first yield as soon as the generator is
+    // called, and begin() does not resume it. simple::generator only:
+    // nested recursive generators are started by their parent.
+    eager,
+};
+
+enum class storage_policy {
+    // The yielded value is copied or moved into the promise.
+    copy,
+    // The promise keeps the address of the yielded object, which lives
+    // until the coroutine is resumed, and the iterator dereferences to a
+    // const reference to it. Only differs from copy when the reference
+    // type is not a reference.
+    address,
+};
+
+enum class timing_policy {
+    untimed,
+    // Each resumption by the iterator is timed, and reported to the
+    // resume_timing sink of the calling thread, if any.
+    timed,
+};
+
+enum class filter_policy {
+    // Every yield of a single value suspends the coroutine.
+    unfiltered,
+    // set_yield_filter() is available, as needed by fused.hpp, at the cost
+    // of a check for a filter on every yield. Requires start_policy::lazy
+    // and, unless the reference type is a reference, storage_policy::copy.
+    filtered,
+};
+
+enum class block_policy {
+    // Values are yielded one at a time.
+    elements,
+    // Contiguous blocks of values can also be yielded as spans, chunks()
+    // hands them out whole, and recursive::generator walks contiguous
+    // elements_of() ranges in place. The promise keeps a cursor into the
+    // current block, checked on every increment, and the pending size_hint
+    // for drain_into(). Requires a reference type constructible from a
+    // const Value &.
+    blocks,
+};
+
+enum class spawn_policy {
+    // Generators yielded with elements_of() run nested.
+    nested,
+    // set_spawner() is available, as needed by parallel_traverse, at the
+    // cost of a pointer in every frame and of a check on every yield of
+    // elements_of() a generator. Only affects recursive::generator.
+    spawnable,
+};
+
+template <exception_policy Exceptions = exception_policy::propagate,
+          start_policy Start = start_policy::lazy,
+          storage_policy Storage = storage_policy::copy,
+          timing_policy Timing = timing_policy::untimed,
+          filter_policy Filter = filter_policy::unfiltered,
+          block_policy Blocks = block_policy::elements,
+          spawn_policy Spawn = spawn_policy::nested>
+struct generator_policy {
+    static constexpr exception_policy exceptions = Exceptions;
+    static constexpr start_policy start = Start;
+    static constexpr storage_policy storage = Storage;
+    static constexpr timing_policy timing = Timing;
+    static constexpr filter_policy filter = Filter;
+    static constexpr block_policy blocks = Blocks;
+    static constexpr spawn_policy spawn = Spawn;
+};
+
+// Receives the durations of the resumptions of timed generators on the
+// calling thread, in ticks of now(): the time stamp counter on x86,
+// nanoseconds elsewhere. See latency.hpp.
+struct resume_timing {
+    using sink_type = void (*)(void *context, std::uint64_t ticks) noexcept;
+
+    sink_type sink = nullptr;
+    void *context = nullptr;
+
+    static std::uint64_t now() noexcept {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count());
+#endif
+    }
+
+    static resume_timing &local() noexcept {
+        static thread_local resume_timing timing;
+        return timing;
+    }
+
+    // Resumes `coro`, timing it if there is a sink.
+    static void resume(std::coroutine_handle<> coro) {
+        const auto &timing = local();
+        if (!timing.sink) {
+            coro.resume();
+            return;
+        }
+        const auto start = now();
+        coro.resume();
+        timing.sink(timing.context, now() - start);
+    }
+};
+
+struct __empty {};
+
+// Stands for a promise member left out by the policy. Each such member
+// needs its own Id: [[no_unique_address]] only lets empty members share
+// an address when their types differ.
+template <int Id>
+struct __omitted {};
+
+// Whether begin() was called, for generators that need to know whether a
+// value must be destroyed in the promise. When not tracked, the generator
+// either always started (eager) or has nothing to destroy.
+template <bool Tracked>
+struct __started_flag {
+    bool started_ = false;
+
+    bool get() const noexcept {
+        return started_;
+    }
+    void set() noexcept {
+        started_ = true;
+    }
+};
+
+template <>
+struct __started_flag<false> {
+    bool get() const noexcept {
+        return true;
+    }
+    void set() noexcept {
     }
 };
 
 namespace recursive {
 
-template <typename Ref, typename Value = std::remove_cvref_t<Ref>, typename Alloc = std::allocator<std::byte>>
+template <typename Ref, typename Value = std::remove_cvref_t<Ref>, typename Alloc = std::allocator<std::byte>,
+          typename Policy = generator_policy<>>
 class generator {
+    static_assert(Policy::start == start_policy::lazy,
+                  "nested recursive generators are started by their parent");
+    static constexpr bool propagates_exceptions = Policy::exceptions == exception_policy::propagate;
+    static constexpr bool lazy = Policy::start == start_policy::lazy;
+    static constexpr bool timed = Policy::timing == timing_policy::timed;
+    static constexpr bool stores_address =
+        Policy::storage == storage_policy::address && !std::is_reference_v<Ref>;
+    static_assert(!stores_address || std::is_same_v<Ref, Value>,
+                  "storage_policy::address requires the value type as reference type");
+
+    // What the promise holds for the current value.
+    using stored_type = std::conditional_t<stores_address, const Ref &, Ref>;
+    static constexpr bool tracks_started =
+        lazy && !std::is_trivially_destructible_v<stored_type>;
+
   public:
+    class spawner;
+
+    // See set_yield_filter().
+    using yield_filter = bool (*)(void *context, Ref &&value) noexcept;
+
+  private:
+    static constexpr bool filterable = Policy::filter == filter_policy::filtered;
+    // The filter must see the first value, and gets it as Ref&&.
+    static_assert(!filterable || (lazy && !stores_address),
+                  "filter_policy::filtered requires start_policy::lazy and storage_policy::copy");
+    // Only a yield filter can let a yield of a single value go on without
+    // suspending.
+    using value_awaiter = std::conditional_t<filterable, __suspend_if, std::suspend_always>;
+    static constexpr bool yields_blocks = Policy::blocks == block_policy::blocks;
+    // Blocks of values can only be yielded when Ref can be made from a
+    // const Value &, which move-only value types cannot.
+    static_assert(!yields_blocks || std::is_convertible_v<const Value &, Ref>,
+                  "block_policy::blocks requires a reference type constructible from const Value &");
+    static constexpr bool spawnable = Policy::spawn == spawn_policy::spawnable;
+
+  public:
+
     class promise_type : public promise_base_type<Alloc> {
       public:
         promise_type() noexcept
@@ -242,9 +553,13 @@ class generator {
         }
 
         void unhandled_exception() {
-            if (exception_ == nullptr)
-                throw;
-            *exception_ = std::current_exception();
+            if constexpr (!propagates_exceptions) {
+                std::terminate();
+            } else {
+                if (exception_ == nullptr)
+                    throw;
+                *exception_ = std::current_exception();
+            }
         }
 
         void return_void() noexcept {
@@ -277,19 +592,56 @@ class generator {
             return {};
         }
 
-        std::suspend_always yield_value(Ref &&x) noexcept(
+        value_awaiter yield_value(Ref &&x) noexcept(
             std::is_nothrow_move_constructible_v<Ref>) {
             auto &root = rootOrLeaf_.promise();
             root.value_.construct((Ref &&) x);
-            return {};
+            return root.value_yielded();
         }
 
         template <typename T>
-        requires(!std::is_reference_v<Ref>) &&
-            std::is_convertible_v<T, Ref> std::suspend_always yield_value(
+        requires(!std::is_reference_v<Ref>) && (!stores_address) &&
+            std::is_convertible_v<T, Ref> value_awaiter yield_value(
                 T &&x) noexcept(std::is_nothrow_constructible_v<Ref, T>) {
             auto &root = rootOrLeaf_.promise();
             root.value_.construct((T &&) x);
+            return root.value_yielded();
+        }
+
+        // With storage_policy::address, the yielded object (or the
+        // temporary it was converted to) outlives the suspension.
+        value_awaiter yield_value(const Ref &x) noexcept requires stores_address {
+            auto &root = rootOrLeaf_.promise();
+            root.value_.construct(x);
+            return root.value_yielded();
+        }
+
+        // Builds the value in place in the root, from the arguments of
+        // construct_in_place(): no temporary to copy or move from.
+        template <typename... Args>
+        requires(!std::is_reference_v<Ref>) && (!stores_address) &&
+            std::is_constructible_v<Ref, Args...> value_awaiter yield_value(
+                __construct_in_place<Args...> in_place) noexcept(std::is_nothrow_constructible_v<Ref, Args...>) {
+            auto &root = rootOrLeaf_.promise();
+            std::apply([&](Args &&...args) { root.value_.construct((Args &&) args...); }, std::move(in_place.args_));
+            return root.value_yielded();
+        }
+
+        // Yields all the elements of a contiguous block with a single
+        // suspension. The consumer steps through the block without resuming
+        // the coroutine, and chunks() hands out the block as a whole.
+        // The block must remain valid until the coroutine is resumed.
+        template <typename T, std::size_t Extent>
+        requires std::is_same_v<std::remove_const_t<T>, Value> && yields_blocks __suspend_if yield_value(
+                std::span<T, Extent> block) noexcept(std::is_nothrow_constructible_v<Ref, const Value &>) {
+            auto &root = rootOrLeaf_.promise();
+            return {root.start_block(block.data(), block.data() + block.size())};
+        }
+
+        // Adds to the size hint of the root, without suspending.
+        std::suspend_never yield_value(size_hint hint) noexcept {
+            if constexpr (yields_blocks)
+                rootOrLeaf_.promise().sizeHint_ += hint.count;
             return {};
         }
 
@@ -297,7 +649,7 @@ class generator {
             using promise_type = generator::promise_type;
 
             generator gen_;
-            std::exception_ptr exception_;
+            [[no_unique_address]] std::conditional_t<propagates_exceptions, std::exception_ptr, __empty> exception_;
 
             yield_sequence_awaiter(generator &&g) noexcept
                 // Taking ownership of the generator ensures frame are destroyed
@@ -320,24 +672,49 @@ class generator {
                 nested.rootOrLeaf_ = current.rootOrLeaf_;
                 root.rootOrLeaf_ = gen_.coro_;
                 nested.parent_ = h;
+                current.nested_ = &gen_;
 
-                nested.exception_ = &exception_;
+                if constexpr (propagates_exceptions)
+                    nested.exception_ = &exception_;
 
                 // Immediately resume the nested coroutine (nested generator)
                 return gen_.coro_;
             }
 
             void await_resume() {
-                if (exception_) {
-                    std::rethrow_exception(std::move(exception_));
+                if constexpr (propagates_exceptions) {
+                    if (exception_) {
+                        std::rethrow_exception(std::move(exception_));
+                    }
                 }
             }
         };
 
         yield_sequence_awaiter yield_value(elements_of<generator> g) noexcept {
+            if constexpr (spawnable) {
+                auto &root = rootOrLeaf_.promise();
+                if (root.spawner_) {
+                    // Not nested: the awaiter holds no generator and is ready.
+                    root.spawner_->spawn((generator &&) std::move(g));
+                    return yield_sequence_awaiter{generator{}};
+                }
+            }
             return yield_sequence_awaiter{(generator &&) std::move(g)};
         }
 
+        // Contiguous ranges of values are walked in place with the block
+        // cursor: no adapter frame and no resumption per element. This
+        // coroutine is only resumed once the range is exhausted.
+        template <typename R>
+        requires std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+            std::is_same_v<std::ranges::range_value_t<R>, Value> && yields_blocks __suspend_if yield_value(
+                elements_of<R> r) noexcept(std::is_nothrow_constructible_v<Ref, const Value &>) {
+            R &&range = std::move(r);
+            const Value *first = std::ranges::data(range);
+            auto &root = rootOrLeaf_.promise();
+            return {root.start_block(first, first + std::ranges::size(range))};
+        }
+
         // Adapt any std::elements_of() range that
         template <typename R>
         // requires std::convertible_to<std::ranges::range_reference_t<R>, Ref>
@@ -348,7 +725,10 @@ class generator {
         }
 
         void resume() {
-            rootOrLeaf_.resume();
+            if constexpr (timed)
+                resume_timing::resume(rootOrLeaf_);
+            else
+                rootOrLeaf_.resume();
         }
 
         // Disable use of co_await within this coroutine.
@@ -356,24 +736,97 @@ class generator {
 
       private:
         friend generator;
+
+        // Runs the yield filter, if any, on the value just constructed.
+        // A rejected value is destroyed and the coroutine goes on.
+        bool accept_value() noexcept {
+            if constexpr (filterable) {
+                if (!yieldFilter_) [[likely]]
+                    return true;
+                if (yieldFilter_(yieldContext_, static_cast<Ref &&>(value_.get())))
+                    return true;
+                value_.destruct();
+                return false;
+            } else {
+                return true;
+            }
+        }
+
+        value_awaiter value_yielded() noexcept {
+            if constexpr (filterable)
+                return {accept_value()};
+            else
+                return {};
+        }
+
+        bool has_yield_filter() const noexcept {
+            if constexpr (filterable)
+                return yieldFilter_ != nullptr;
+            else
+                return false;
+        }
+
+        bool start_block(const Value *first, const Value *last) {
+            blockNext_ = first;
+            blockEnd_ = last;
+            return next_in_block();
+        }
+
+        // Moves to the next element of the current block, if any.
+        bool next_in_block() {
+            if constexpr (yields_blocks) {
+                if (!blockEnd_)
+                    return false;
+                while (blockNext_ != blockEnd_) {
+                    value_.construct(*blockNext_++);
+                    if (accept_value())
+                        return true;
+                }
+                blockNext_ = blockEnd_ = nullptr;
+            }
+            return false;
+        }
+
+        std::span<const Value> current_block() noexcept {
+            if (blockEnd_ && !has_yield_filter())
+                return {blockNext_ - 1, blockEnd_};
+            const Value &value = value_.get();
+            return {std::addressof(value), 1};
+        }
+
         std::coroutine_handle<promise_type> rootOrLeaf_;
         std::coroutine_handle<promise_type> parent_;
-        std::exception_ptr *exception_ = nullptr;
-        __manual_lifetime<Ref> value_;
+        // Generator owning the nested coroutine this one is suspended on,
+        // if any. Only read when tearing down a chain.
+        generator *nested_ = nullptr;
+        [[no_unique_address]] std::conditional_t<propagates_exceptions, std::exception_ptr *, __omitted<0>> exception_{};
+        // Only used in the root.
+        [[no_unique_address]] std::conditional_t<spawnable, spawner *, __omitted<7>> spawner_{};
+        __manual_lifetime<stored_type> value_;
+        // Only used in the root: remaining elements of a yielded block.
+        [[no_unique_address]] std::conditional_t<yields_blocks, const Value *, __omitted<2>> blockNext_{};
+        [[no_unique_address]] std::conditional_t<yields_blocks, const Value *, __omitted<3>> blockEnd_{};
+        // Only used in the root.
+        [[no_unique_address]] std::conditional_t<filterable, yield_filter, __omitted<4>> yieldFilter_{};
+        [[no_unique_address]] std::conditional_t<filterable, void *, __omitted<5>> yieldContext_{};
+        // Only used in the root: values announced with size_hint that
+        // drain_into() has not reserved room for yet.
+        [[no_unique_address]] std::conditional_t<yields_blocks, std::size_t, __omitted<6>> sizeHint_{};
     };
 
     generator() noexcept = default;
 
     generator(generator &&other) noexcept
         : coro_(std::exchange(other.coro_, {})),
-          started_(std::exchange(other.started_, false)) {
+          started_(std::exchange(other.started_, {})) {
     }
 
     ~generator() noexcept {
         if (coro_) {
-            if (started_ && !coro_.done()) {
+            if (started_.get() && !coro_.done()) {
                 coro_.promise().value_.destruct();
             }
+            destroy_nested();
             coro_.destroy();
         }
     }
@@ -388,6 +841,44 @@ class generator {
         std::swap(started_, other.started_);
     }
 
+    // Receives the generators yielded with elements_of() by this generator,
+    // instead of running them nested. This is how parallel_traverse turns
+    // nested generators into tasks. Must be set before begin(), and only
+    // with spawn_policy::spawnable.
+    class spawner {
+      public:
+        virtual void spawn(generator &&g) = 0;
+
+      protected:
+        ~spawner() = default;
+
+        // Conversions from and to a pointer-sized task.
+        static void *release(generator &g) noexcept {
+            g.started_ = {};
+            return std::exchange(g.coro_, {}).address();
+        }
+        static generator adopt(void *task) noexcept {
+            return generator{std::coroutine_handle<promise_type>::from_address(task)};
+        }
+    };
+
+    void set_spawner(spawner *s) noexcept requires spawnable {
+        if (coro_)
+            coro_.promise().spawner_ = s;
+    }
+
+    // Calls `filter(context, value)` on the producer side, right after
+    // each value is yielded, block elements included. A value the filter
+    // rejects is dropped and the coroutine goes on without resuming the
+    // consumer. This is how fused adaptors run inside the generator.
+    // Must be set before begin(). Only with filter_policy::filtered.
+    void set_yield_filter(yield_filter filter, void *context) noexcept requires filterable {
+        if (coro_) {
+            coro_.promise().yieldFilter_ = filter;
+            coro_.promise().yieldContext_ = context;
+        }
+    }
+
     struct sentinel {};
 
     class iterator {
@@ -397,8 +888,10 @@ class generator {
         using iterator_category = std::input_iterator_tag;
         using difference_type = std::ptrdiff_t;
         using value_type = Value;
-        using reference = Ref;
-        using pointer = std::add_pointer_t<Ref>;
+        // With storage_policy::address, a reference to the yielded object
+        // itself rather than a copy of it.
+        using reference = std::conditional_t<stores_address, const Value &, Ref>;
+        using pointer = std::add_pointer_t<reference>;
 
         iterator() noexcept = default;
         iterator(const iterator &) = delete;
@@ -419,8 +912,13 @@ class generator {
         }
 
         iterator &operator++() {
-            coro_.promise().value_.destruct();
-            coro_.promise().resume();
+            auto &promise = coro_.promise();
+            promise.value_.destruct();
+            if constexpr (yields_blocks) {
+                if (promise.next_in_block())
+                    return *this;
+            }
+            promise.resume();
             return *this;
         }
         void operator++(int) {
@@ -445,7 +943,7 @@ class generator {
 
     iterator begin() {
         if (coro_) {
-            started_ = true;
+            started_.set();
             coro_.resume();
         }
         return iterator{coro_};
@@ -455,32 +953,223 @@ class generator {
         return {};
     }
 
+    // Iterates over the generated values block by block: a block yielded
+    // as a span is seen in one step, any other value as a block of one.
+    // With a yield filter, the elements the filter accepts are each seen
+    // as a block of one.
+    class chunk_iterator {
+        using coroutine_handle = std::coroutine_handle<promise_type>;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::span<const Value>;
+        using reference = std::span<const Value>;
+
+        chunk_iterator() noexcept = default;
+        chunk_iterator(const chunk_iterator &) = delete;
+
+        chunk_iterator(chunk_iterator &&o) noexcept
+            : coro_(std::exchange(o.coro_, {})) {
+        }
+
+        chunk_iterator &operator=(chunk_iterator &&o) {
+            std::swap(coro_, o.coro_);
+            return *this;
+        }
+
+        friend bool operator==(const chunk_iterator &it, sentinel) noexcept {
+            return !it.coro_ || it.coro_.done();
+        }
+
+        chunk_iterator &operator++() {
+            auto &promise = coro_.promise();
+            promise.value_.destruct();
+            if (promise.has_yield_filter()) {
+                if (!promise.next_in_block())
+                    promise.resume();
+                return *this;
+            }
+            promise.blockNext_ = promise.blockEnd_ = nullptr;
+            promise.resume();
+            return *this;
+        }
+        void operator++(int) {
+            (void)operator++();
+        }
+
+        reference operator*() const noexcept {
+            return coro_.promise().current_block();
+        }
+
+      private:
+        friend generator;
+        explicit chunk_iterator(coroutine_handle coro) noexcept : coro_(coro) {
+        }
+
+        coroutine_handle coro_;
+    };
+
+    class chunk_range {
+      public:
+        chunk_iterator begin() {
+            return chunk_iterator{gen_.begin().coro_};
+        }
+
+        sentinel end() noexcept {
+            return {};
+        }
+
+      private:
+        friend generator;
+        explicit chunk_range(generator &gen) noexcept : gen_(gen) {
+        }
+
+        generator &gen_;
+    };
+
+    // Must be called instead of, not in addition to, begin(). Only with
+    // block_policy::blocks.
+    chunk_range chunks() noexcept requires yields_blocks && std::is_same_v<std::remove_cvref_t<Ref>, Value> {
+        return chunk_range{*this};
+    }
+
+    // Appends the values to `out` with push_back(), straight from the
+    // promise rather than through an iterator, and returns it. Size hints
+    // reserve room as they come, and blocks yielded as spans are appended
+    // with a single insert() unless a yield filter has to see their
+    // elements. Must be called instead of, not in addition to, begin().
+    template <typename Container>
+    Container &drain_into(Container &out) {
+        if (!coro_)
+            return out;
+        (void)begin();
+        auto &promise = coro_.promise();
+        while (!coro_.done()) {
+            if constexpr (yields_blocks) {
+                if (promise.sizeHint_ != 0)
+                    __reserve_hint(out, std::exchange(promise.sizeHint_, 0));
+            }
+            if constexpr (yields_blocks && requires { out.insert(out.end(), promise.blockNext_, promise.blockEnd_); }) {
+                if (promise.blockEnd_ && !promise.has_yield_filter()) {
+                    out.insert(out.end(), promise.blockNext_ - 1, promise.blockEnd_);
+                    promise.value_.destruct();
+                    promise.blockNext_ = promise.blockEnd_ = nullptr;
+                    promise.resume();
+                    continue;
+                }
+            }
+            if constexpr (stores_address)
+                out.push_back(promise.value_.get());
+            else
+                out.push_back(static_cast<Ref &&>(promise.value_.get()));
+            promise.value_.destruct();
+            if constexpr (yields_blocks) {
+                if (promise.next_in_block())
+                    continue;
+            }
+            promise.resume();
+        }
+        return out;
+    }
+
+    // The values in a vector, with drain_into(). Must be called instead
+    // of, not in addition to, begin().
+    std::vector<Value> to_vector() {
+        std::vector<Value> out;
+        drain_into(out);
+        return out;
+    }
+
   private:
+    // Destroying a suspended root would destroy its nested generator,
+    // which destroys its own nested generator, and so on: one native
+    // stack frame per level. Instead, destroy the frames from the leaf
+    // up, detaching each from its parent first, so that chains of any
+    // depth are torn down in constant stack space, in the same
+    // (reverse creation) order.
+    void destroy_nested() noexcept {
+        auto &root = coro_.promise();
+        if (root.parent_)
+            return;
+        for (auto leaf = root.rootOrLeaf_; leaf != coro_;) {
+            auto parent = leaf.promise().parent_;
+            parent.promise().nested_->coro_ = {};
+            leaf.destroy();
+            leaf = parent;
+        }
+    }
+
     explicit generator(std::coroutine_handle<promise_type> coro) noexcept
         : coro_(coro) {
     }
 
     std::coroutine_handle<promise_type> coro_;
-    bool started_ = false;
+    [[no_unique_address]] __started_flag<tracks_started> started_;
 };
 
 }
 
 #if __has_include(<ranges>)
-template <typename T, typename U>
-constexpr inline bool std::ranges::enable_view<recursive::generator<T, U>> = true;
+template <typename T, typename U, typename A, typename P>
+constexpr inline bool std::ranges::enable_view<recursive::generator<T, U, A, P>> = true;
+
+// Move-only iterators, compared one-sided with an empty sentinel: an
+// input_range but not a forward_range, as for std::generator.
+static_assert(std::input_iterator<recursive::generator<int>::iterator>);
+static_assert(std::sentinel_for<recursive::generator<int>::sentinel, recursive::generator<int>::iterator>);
+static_assert(std::ranges::input_range<recursive::generator<int>>);
+static_assert(std::ranges::view<recursive::generator<const int &>>);
+static_assert(!std::ranges::forward_range<recursive::generator<int>>);
 #endif
 
 
 namespace simple {
 
-template <typename Ref, typename Value = std::remove_cvref_t<Ref>, typename Alloc = std::allocator<std::byte>>
+template <typename Ref, typename Value = std::remove_cvref_t<Ref>, typename Alloc = std::allocator<std::byte>,
+          typename Policy = generator_policy<>>
 class generator {
+    static constexpr bool propagates_exceptions = Policy::exceptions == exception_policy::propagate;
+    static constexpr bool lazy = Policy::start == start_policy::lazy;
+    static constexpr bool timed = Policy::timing == timing_policy::timed;
+    static constexpr bool stores_address =
+        Policy::storage == storage_policy::address && !std::is_reference_v<Ref>;
+    static_assert(!stores_address || std::is_same_v<Ref, Value>,
+                  "storage_policy::address requires the value type as reference type");
+
+    // What the promise holds for the current value.
+    using stored_type = std::conditional_t<stores_address, const Ref &, Ref>;
+    static constexpr bool tracks_started =
+        lazy && !std::is_trivially_destructible_v<stored_type>;
+
+  public:
+    // See set_yield_filter().
+    using yield_filter = bool (*)(void *context, Ref &&value) noexcept;
+
+  private:
+    static constexpr bool filterable = Policy::filter == filter_policy::filtered;
+    // The filter must see the first value, and gets it as Ref&&.
+    static_assert(!filterable || (lazy && !stores_address),
+                  "filter_policy::filtered requires start_policy::lazy and storage_policy::copy");
+    // Only a yield filter can let a yield of a single value go on without
+    // suspending.
+    using value_awaiter = std::conditional_t<filterable, __suspend_if, std::suspend_always>;
+    static constexpr bool yields_blocks = Policy::blocks == block_policy::blocks;
+    // Blocks of values can only be yielded when Ref can be made from a
+    // const Value &, which move-only value types cannot.
+    static_assert(!yields_blocks || std::is_convertible_v<const Value &, Ref>,
+                  "block_policy::blocks requires a reference type constructible from const Value &");
+
   public:
+
     class promise_type : public promise_base_type<Alloc> {
       public:
         promise_type() noexcept
         {
+            // An exception escaping an eager body before its first yield
+            // is kept for begin(), rather than thrown out of the call.
+            if constexpr (!lazy && propagates_exceptions)
+                exception_ = &initialException_;
         }
 
         generator get_return_object() noexcept {
@@ -489,27 +1178,64 @@ class generator {
         }
 
         void unhandled_exception() {
-            if (exception_ == nullptr)
-                throw;
-            *exception_ = std::current_exception();
+            if constexpr (!propagates_exceptions) {
+                std::terminate();
+            } else {
+                if (exception_ == nullptr)
+                    throw;
+                *exception_ = std::current_exception();
+            }
         }
 
         void return_void() noexcept {
         }
 
-        std::suspend_always initial_suspend() noexcept {
+        std::conditional_t<lazy, std::suspend_always, std::suspend_never> initial_suspend() noexcept {
             return {};
         }
-        std::suspend_always yield_value(Ref &&x) noexcept(
+        value_awaiter yield_value(Ref &&x) noexcept(
             std::is_nothrow_move_constructible_v<Ref>) {
             value_.construct((Ref &&) x);
-            return {};
+            return value_yielded();
         }
 
         template <typename T>
-        requires(!std::is_reference_v<Ref>) && std::is_convertible_v<T, Ref> std::suspend_always yield_value(
+        requires(!std::is_reference_v<Ref>) && (!stores_address) && std::is_convertible_v<T, Ref> value_awaiter yield_value(
                 T &&x) noexcept(std::is_nothrow_constructible_v<Ref, T>) {
             value_.construct((T &&) x);
+            return value_yielded();
+        }
+
+        // With storage_policy::address, the yielded object (or the
+        // temporary it was converted to) outlives the suspension.
+        value_awaiter yield_value(const Ref &x) noexcept requires stores_address {
+            value_.construct(x);
+            return value_yielded();
+        }
+
+        // Builds the value in place from the arguments of
+        // construct_in_place(): no temporary to copy or move from.
+        template <typename... Args>
+        requires(!std::is_reference_v<Ref>) && (!stores_address) &&
+            std::is_constructible_v<Ref, Args...> value_awaiter yield_value(
+                __construct_in_place<Args...> in_place) noexcept(std::is_nothrow_constructible_v<Ref, Args...>) {
+            std::apply([&](Args &&...args) { value_.construct((Args &&) args...); }, std::move(in_place.args_));
+            return value_yielded();
+        }
+
+        // Yields all the elements of a contiguous block with a single
+        // suspension. The block must remain valid until the coroutine is
+        // resumed.
+        template <typename T, std::size_t Extent>
+        requires std::is_same_v<std::remove_const_t<T>, Value> && yields_blocks __suspend_if yield_value(
+                std::span<T, Extent> block) noexcept(std::is_nothrow_constructible_v<Ref, const Value &>) {
+            return {start_block(block.data(), block.data() + block.size())};
+        }
+
+        // Adds to the size hint, without suspending.
+        std::suspend_never yield_value(size_hint hint) noexcept {
+            if constexpr (yields_blocks)
+                sizeHint_ += hint.count;
             return {};
         }
 
@@ -518,7 +1244,11 @@ class generator {
         }
 
         void resume() {
-            std::coroutine_handle<promise_type>::from_promise(*this).resume();
+            const auto coro = std::coroutine_handle<promise_type>::from_promise(*this);
+            if constexpr (timed)
+                resume_timing::resume(coro);
+            else
+                coro.resume();
         }
 
         // Disable use of co_await within this coroutine.
@@ -526,20 +1256,88 @@ class generator {
 
       private:
         friend generator;
-        std::exception_ptr *exception_ = nullptr;
-        __manual_lifetime<Ref> value_;
+
+        // Runs the yield filter, if any, on the value just constructed.
+        // A rejected value is destroyed and the coroutine goes on.
+        bool accept_value() noexcept {
+            if constexpr (filterable) {
+                if (!yieldFilter_) [[likely]]
+                    return true;
+                if (yieldFilter_(yieldContext_, static_cast<Ref &&>(value_.get())))
+                    return true;
+                value_.destruct();
+                return false;
+            } else {
+                return true;
+            }
+        }
+
+        value_awaiter value_yielded() noexcept {
+            if constexpr (filterable)
+                return {accept_value()};
+            else
+                return {};
+        }
+
+        bool has_yield_filter() const noexcept {
+            if constexpr (filterable)
+                return yieldFilter_ != nullptr;
+            else
+                return false;
+        }
+
+        bool start_block(const Value *first, const Value *last) {
+            blockNext_ = first;
+            blockEnd_ = last;
+            return next_in_block();
+        }
+
+        // Moves to the next element of the current block, if any.
+        bool next_in_block() {
+            if constexpr (yields_blocks) {
+                if (!blockEnd_)
+                    return false;
+                while (blockNext_ != blockEnd_) {
+                    value_.construct(*blockNext_++);
+                    if (accept_value())
+                        return true;
+                }
+                blockNext_ = blockEnd_ = nullptr;
+            }
+            return false;
+        }
+
+        std::span<const Value> current_block() noexcept {
+            if (blockEnd_ && !has_yield_filter())
+                return {blockNext_ - 1, blockEnd_};
+            const Value &value = value_.get();
+            return {std::addressof(value), 1};
+        }
+
+        [[no_unique_address]] std::conditional_t<propagates_exceptions, std::exception_ptr *, __omitted<0>> exception_{};
+        [[no_unique_address]] std::conditional_t<!lazy && propagates_exceptions, std::exception_ptr, __omitted<1>>
+            initialException_;
+        __manual_lifetime<stored_type> value_;
+        // Remaining elements of a yielded block.
+        [[no_unique_address]] std::conditional_t<yields_blocks, const Value *, __omitted<2>> blockNext_{};
+        [[no_unique_address]] std::conditional_t<yields_blocks, const Value *, __omitted<3>> blockEnd_{};
+        [[no_unique_address]] std::conditional_t<filterable, yield_filter, __omitted<4>> yieldFilter_{};
+        [[no_unique_address]] std::conditional_t<filterable, void *, __omitted<5>> yieldContext_{};
+        // Values announced with size_hint that drain_into() has not
+        // reserved room for yet.
+        [[no_unique_address]] std::conditional_t<yields_blocks, std::size_t, __omitted<6>> sizeHint_{};
     };
 
     generator() noexcept = default;
 
     generator(generator &&other) noexcept
         : coro_(std::exchange(other.coro_, {})),
-          started_(std::exchange(other.started_, false)) {
+          started_(std::exchange(other.started_, {})) {
     }
 
     ~generator() noexcept {
         if (coro_) {
-            if (started_ && !coro_.done()) {
+            if (started_.get() && !coro_.done()) {
                 coro_.promise().value_.destruct();
             }
             coro_.destroy();
@@ -556,6 +1354,18 @@ class generator {
         std::swap(started_, other.started_);
     }
 
+    // Calls `filter(context, value)` on the producer side, right after
+    // each value is yielded, block elements included. A value the filter
+    // rejects is dropped and the coroutine goes on without resuming the
+    // consumer. This is how fused adaptors run inside the generator.
+    // Must be set before begin(). Only with filter_policy::filtered.
+    void set_yield_filter(yield_filter filter, void *context) noexcept requires filterable {
+        if (coro_) {
+            coro_.promise().yieldFilter_ = filter;
+            coro_.promise().yieldContext_ = context;
+        }
+    }
+
     struct sentinel {};
 
     class iterator {
@@ -565,8 +1375,10 @@ class generator {
         using iterator_category = std::input_iterator_tag;
         using difference_type = std::ptrdiff_t;
         using value_type = Value;
-        using reference = Ref;
-        using pointer = std::add_pointer_t<Ref>;
+        // With storage_policy::address, a reference to the yielded object
+        // itself rather than a copy of it.
+        using reference = std::conditional_t<stores_address, const Value &, Ref>;
+        using pointer = std::add_pointer_t<reference>;
 
         iterator() noexcept = default;
         iterator(const iterator &) = delete;
@@ -587,8 +1399,13 @@ class generator {
         }
 
         iterator &operator++() {
-            coro_.promise().value_.destruct();
-            coro_.promise().resume();
+            auto &promise = coro_.promise();
+            promise.value_.destruct();
+            if constexpr (yields_blocks) {
+                if (promise.next_in_block())
+                    return *this;
+            }
+            promise.resume();
             return *this;
         }
         void operator++(int) {
@@ -613,8 +1430,15 @@ class generator {
 
     iterator begin() {
         if (coro_) {
-            started_ = true;
-            coro_.resume();
+            started_.set();
+            if constexpr (lazy) {
+                coro_.resume();
+            } else if constexpr (propagates_exceptions) {
+                auto &promise = coro_.promise();
+                promise.exception_ = nullptr;
+                if (promise.initialException_)
+                    std::rethrow_exception(std::exchange(promise.initialException_, nullptr));
+            }
         }
         return iterator{coro_};
     }
@@ -623,18 +1447,395 @@ class generator {
         return {};
     }
 
+    // Iterates over the generated values block by block: a block yielded
+    // as a span is seen in one step, any other value as a block of one.
+    // With a yield filter, the elements the filter accepts are each seen
+    // as a block of one.
+    class chunk_iterator {
+        using coroutine_handle = std::coroutine_handle<promise_type>;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::span<const Value>;
+        using reference = std::span<const Value>;
+
+        chunk_iterator() noexcept = default;
+        chunk_iterator(const chunk_iterator &) = delete;
+
+        chunk_iterator(chunk_iterator &&o) noexcept
+            : coro_(std::exchange(o.coro_, {})) {
+        }
+
+        chunk_iterator &operator=(chunk_iterator &&o) {
+            std::swap(coro_, o.coro_);
+            return *this;
+        }
+
+        friend bool operator==(const chunk_iterator &it, sentinel) noexcept {
+            return !it.coro_ || it.coro_.done();
+        }
+
+        chunk_iterator &operator++() {
+            auto &promise = coro_.promise();
+            promise.value_.destruct();
+            if (promise.has_yield_filter()) {
+                if (!promise.next_in_block())
+                    promise.resume();
+                return *this;
+            }
+            promise.blockNext_ = promise.blockEnd_ = nullptr;
+            promise.resume();
+            return *this;
+        }
+        void operator++(int) {
+            (void)operator++();
+        }
+
+        reference operator*() const noexcept {
+            return coro_.promise().current_block();
+        }
+
+      private:
+        friend generator;
+        explicit chunk_iterator(coroutine_handle coro) noexcept : coro_(coro) {
+        }
+
+        coroutine_handle coro_;
+    };
+
+    class chunk_range {
+      public:
+        chunk_iterator begin() {
+            return chunk_iterator{gen_.begin().coro_};
+        }
+
+        sentinel end() noexcept {
+            return {};
+        }
+
+      private:
+        friend generator;
+        explicit chunk_range(generator &gen) noexcept : gen_(gen) {
+        }
+
+        generator &gen_;
+    };
+
+    // Must be called instead of, not in addition to, begin(). Only with
+    // block_policy::blocks.
+    chunk_range chunks() noexcept requires yields_blocks && std::is_same_v<std::remove_cvref_t<Ref>, Value> {
+        return chunk_range{*this};
+    }
+
+    // Appends the values to `out` with push_back(), straight from the
+    // promise rather than through an iterator, and returns it. Size hints
+    // reserve room as they come, and blocks yielded as spans are appended
+    // with a single insert() unless a yield filter has to see their
+    // elements. Must be called instead of, not in addition to, begin().
+    template <typename Container>
+    Container &drain_into(Container &out) {
+        if (!coro_)
+            return out;
+        (void)begin();
+        auto &promise = coro_.promise();
+        while (!coro_.done()) {
+            if constexpr (yields_blocks) {
+                if (promise.sizeHint_ != 0)
+                    __reserve_hint(out, std::exchange(promise.sizeHint_, 0));
+            }
+            if constexpr (yields_blocks && requires { out.insert(out.end(), promise.blockNext_, promise.blockEnd_); }) {
+                if (promise.blockEnd_ && !promise.has_yield_filter()) {
+                    out.insert(out.end(), promise.blockNext_ - 1, promise.blockEnd_);
+                    promise.value_.destruct();
+                    promise.blockNext_ = promise.blockEnd_ = nullptr;
+                    promise.resume();
+                    continue;
+                }
+            }
+            if constexpr (stores_address)
+                out.push_back(promise.value_.get());
+            else
+                out.push_back(static_cast<Ref &&>(promise.value_.get()));
+            promise.value_.destruct();
+            if constexpr (yields_blocks) {
+                if (promise.next_in_block())
+                    continue;
+            }
+            promise.resume();
+        }
+        return out;
+    }
+
+    // The values in a vector, with drain_into(). Must be called instead
+    // of, not in addition to, begin().
+    std::vector<Value> to_vector() {
+        std::vector<Value> out;
+        drain_into(out);
+        return out;
+    }
+
   private:
     explicit generator(std::coroutine_handle<promise_type> coro) noexcept
         : coro_(coro) {
     }
 
     std::coroutine_handle<promise_type> coro_;
-    bool started_ = false;
+    [[no_unique_address]] __started_flag<tracks_started> started_;
 };
 
 }
 
 #if __has_include(<ranges>)
-template <typename T, typename U>
-constexpr inline bool std::ranges::enable_view<simple::generator<T, U>> = true;
-#endif
\ No newline at end of file
+template <typename T, typename U, typename A, typename P>
+constexpr inline bool std::ranges::enable_view<simple::generator<T, U, A, P>> = true;
+
+// Move-only iterators, compared one-sided with an empty sentinel: an
+// input_range but not a forward_range, as for std::generator.
+static_assert(std::input_iterator<simple::generator<int>::iterator>);
+static_assert(std::sentinel_for<simple::generator<int>::sentinel, simple::generator<int>::iterator>);
+static_assert(std::ranges::input_range<simple::generator<int>>);
+static_assert(std::ranges::view<simple::generator<const int &>>);
+static_assert(!std::ranges::forward_range<simple::generator<int>>);
+#endif
+
+namespace async {
+
+// Generator whose body may co_await, consumed from another coroutine with
+// `while (auto *v = co_await gen.next())`.
+//
+// Like recursive::generator, nested generators yielded with elements_of()
+// are resumed through symmetric transfer, and values are stored in the
+// root. Yielding transfers control straight back to the awaiting consumer.
+// A generator must not be destroyed while suspended in a co_await other
+// than a co_yield, as whatever it awaits would resume a destroyed frame.
+template <typename Ref, typename Value = std::remove_cvref_t<Ref>, typename Alloc = std::allocator<std::byte>>
+class generator {
+  public:
+    using pointer = std::add_pointer_t<std::remove_reference_t<Ref>>;
+
+    class promise_type : public promise_base_type<Alloc> {
+      public:
+        promise_type() noexcept
+            : rootOrLeaf_(
+                  std::coroutine_handle<promise_type>::from_promise(*this))
+        {
+        }
+
+        generator get_return_object() noexcept {
+            return generator{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        void unhandled_exception() {
+            if (exception_ == nullptr)
+                throw;
+            *exception_ = std::current_exception();
+        }
+
+        void return_void() noexcept {
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        // Transfers control back to the parent of a nested coroutine,
+        // or to the consumer once the root is done.
+        struct final_awaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                auto &promise = h.promise();
+                std::coroutine_handle<promise_type> parent = promise.parent_;
+                if (parent) {
+                    auto &root = promise.rootOrLeaf_.promise();
+                    root.rootOrLeaf_ = parent;
+                    return parent;
+                }
+                return promise.consumer_;
+            }
+            void await_resume() noexcept {
+            }
+        };
+
+        final_awaiter final_suspend() noexcept {
+            return {};
+        }
+
+        // Hands the value over to the consumer
+        struct yield_awaiter {
+            promise_type &root_;
+
+            bool await_ready() noexcept {
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<>) noexcept {
+                return root_.consumer_;
+            }
+            void await_resume() noexcept {
+            }
+        };
+
+        yield_awaiter yield_value(Ref &&x) noexcept(
+            std::is_nothrow_move_constructible_v<Ref>) {
+            auto &root = rootOrLeaf_.promise();
+            root.value_.construct((Ref &&) x);
+            root.hasValue_ = true;
+            return {root};
+        }
+
+        template <typename T>
+        requires(!std::is_reference_v<Ref>) &&
+            std::is_convertible_v<T, Ref> yield_awaiter yield_value(
+                T &&x) noexcept(std::is_nothrow_constructible_v<Ref, T>) {
+            auto &root = rootOrLeaf_.promise();
+            root.value_.construct((T &&) x);
+            root.hasValue_ = true;
+            return {root};
+        }
+
+        struct yield_sequence_awaiter {
+            using promise_type = generator::promise_type;
+
+            generator gen_;
+            std::exception_ptr exception_;
+
+            yield_sequence_awaiter(generator &&g) noexcept
+                // Taking ownership of the generator ensures frame are destroyed
+                // in the reverse order of their creation
+                : gen_(std::move(g)) {
+            }
+
+            bool await_ready() noexcept {
+                return !gen_.coro_;
+            }
+
+            // set the parent, root and exceptions pointer and
+            // resume the nested coroutine
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                auto &current = h.promise();
+                auto &nested = gen_.coro_.promise();
+                auto &root = current.rootOrLeaf_.promise();
+
+                nested.rootOrLeaf_ = current.rootOrLeaf_;
+                root.rootOrLeaf_ = gen_.coro_;
+                nested.parent_ = h;
+
+                nested.exception_ = &exception_;
+
+                // Immediately resume the nested coroutine (nested generator)
+                return gen_.coro_;
+            }
+
+            void await_resume() {
+                if (exception_) {
+                    std::rethrow_exception(std::move(exception_));
+                }
+            }
+        };
+
+        yield_sequence_awaiter yield_value(elements_of<generator> g) noexcept {
+            return yield_sequence_awaiter{(generator &&) std::move(g)};
+        }
+
+        // Adapt any std::elements_of() range
+        template <typename R>
+        yield_sequence_awaiter yield_value(elements_of<R> r) {
+           R &&range = std::move(r);
+           for (auto &&v : range)
+                co_yield v;
+        }
+
+      private:
+        friend generator;
+        std::coroutine_handle<promise_type> rootOrLeaf_;
+        std::coroutine_handle<promise_type> parent_;
+        std::exception_ptr *exception_ = nullptr;
+        // Only used in the root.
+        std::coroutine_handle<> consumer_;
+        __manual_lifetime<Ref> value_;
+        bool hasValue_ = false;
+    };
+
+    generator() noexcept = default;
+
+    generator(generator &&other) noexcept
+        : coro_(std::exchange(other.coro_, {})) {
+    }
+
+    ~generator() noexcept {
+        if (coro_) {
+            if (coro_.promise().hasValue_) {
+                coro_.promise().value_.destruct();
+            }
+            coro_.destroy();
+        }
+    }
+
+    generator &operator=(generator g) noexcept {
+        swap(g);
+        return *this;
+    }
+
+    void swap(generator &other) noexcept {
+        std::swap(coro_, other.coro_);
+    }
+
+    // Resumes the generator until it yields its next value, and produces
+    // a pointer to that value, or nullptr once the generator is done.
+    // The value stays valid until the next call to next().
+    class next_awaiter {
+        using coroutine_handle = std::coroutine_handle<promise_type>;
+
+      public:
+        bool await_ready() noexcept {
+            return !coro_ || coro_.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+            auto &root = coro_.promise();
+            if (root.hasValue_) {
+                root.value_.destruct();
+                root.hasValue_ = false;
+            }
+            root.consumer_ = consumer;
+            root.exception_ = &exception_;
+            return root.rootOrLeaf_;
+        }
+
+        pointer await_resume() {
+            if (exception_) {
+                std::rethrow_exception(std::move(exception_));
+            }
+            if (!coro_ || coro_.done())
+                return nullptr;
+            auto &&value = coro_.promise().value_.get();
+            return std::addressof(value);
+        }
+
+      private:
+        friend generator;
+        explicit next_awaiter(coroutine_handle coro) noexcept : coro_(coro) {
+        }
+
+        coroutine_handle coro_;
+        std::exception_ptr exception_;
+    };
+
+    next_awaiter next() noexcept {
+        return next_awaiter{coro_};
+    }
+
+  private:
+    explicit generator(std::coroutine_handle<promise_type> coro) noexcept
+        : coro_(coro) {
+    }
+
+    std::coroutine_handle<promise_type> coro_;
+};
+
+}
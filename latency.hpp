@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////
+// Latency distribution of generator resumptions.
+//
+//   using timed_policy = generator_policy<exception_policy::propagate, start_policy::lazy,
+//                                         storage_policy::copy, timing_policy::timed>;
+//   latency_histogram histogram;
+//   {
+//       resume_latency_recorder recorder(histogram);
+//       for (auto &&v : gen())      // a generator with timed_policy
+//           ...
+//   }
+//   double p99 = histogram.percentile_ns(0.99);
+//
+// Each resumption of a timed generator by its iterator is timed with two
+// resume_timing::now() time stamps. The cost of taking the time stamps
+// themselves, measured once per thread, is subtracted from every sample.
+//
+// latency_histogram is log-linear: each power of two is split into 32
+// linear buckets, which bounds the relative error by about 3% at any
+// scale, with a constant-time record() and no allocation.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+class latency_histogram {
+    // log2 of the number of buckets per power of two.
+    static constexpr unsigned sub_bits = 5;
+    static constexpr std::uint64_t sub_count = std::uint64_t(1) << sub_bits;
+    // Values below 2 * sub_count have a bucket each, then each power of two
+    // up to 2^64 has sub_count buckets.
+    static constexpr std::size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+  public:
+    // Durations are in resume_timing::now() ticks.
+    void record(std::uint64_t ticks) noexcept {
+        ++counts_[bucket(ticks)];
+        ++total_;
+        max_ = std::max(max_, ticks);
+    }
+
+    void merge(const latency_histogram &other) noexcept {
+        for (std::size_t i = 0; i < bucket_count; ++i)
+            counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    void clear() noexcept {
+        counts_.fill(0);
+        total_ = 0;
+        max_ = 0;
+    }
+
+    std::uint64_t count() const noexcept {
+        return total_;
+    }
+
+    std::uint64_t max() const noexcept {
+        return max_;
+    }
+
+    // Upper bound of the bucket holding the q-th quantile (0 < q <= 1),
+    // never more than the largest value recorded.
+    std::uint64_t percentile(double q) const noexcept {
+        if (total_ == 0)
+            return 0;
+        const auto rank = std::max<std::uint64_t>(1, std::uint64_t(std::ceil(q * double(total_))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += counts_[i];
+            if (seen >= rank)
+                return std::min(upper_bound(i), max_);
+        }
+        return max_;
+    }
+
+    double percentile_ns(double q) const noexcept {
+        return to_ns(percentile(q));
+    }
+
+    double max_ns() const noexcept {
+        return to_ns(max_);
+    }
+
+    static double to_ns(std::uint64_t ticks) noexcept {
+        return double(ticks) / ticks_per_ns();
+    }
+
+    // Rate of resume_timing::now(), measured once against steady_clock.
+    static double ticks_per_ns() noexcept {
+        static const double rate = [] {
+            using clock = std::chrono::steady_clock;
+            const auto start = clock::now();
+            const auto startTicks = resume_timing::now();
+            auto end = start;
+            while (end - start < std::chrono::milliseconds(10))
+                end = clock::now();
+            const auto ticks = resume_timing::now() - startTicks;
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            return ticks == 0 || ns == 0 ? 1.0 : double(ticks) / double(ns);
+        }();
+        return rate;
+    }
+
+  private:
+    static std::size_t bucket(std::uint64_t v) noexcept {
+        if (v < 2 * sub_count)
+            return std::size_t(v);
+        const unsigned shift = unsigned(std::bit_width(v)) - 1 - sub_bits;
+        return std::size_t((std::uint64_t(shift) << sub_bits) + (v >> shift));
+    }
+
+    static std::uint64_t upper_bound(std::size_t i) noexcept {
+        if (i < 2 * sub_count)
+            return i;
+        const unsigned shift = unsigned(i >> sub_bits) - 1;
+        const std::uint64_t mantissa = i - (std::uint64_t(shift) << sub_bits);
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::array<std::uint64_t, bucket_count> counts_ = {};
+    std::uint64_t total_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+// Records the resumptions of timed generators on the calling thread into
+// a histogram, for the lifetime of the recorder. Recorders nest.
+class resume_latency_recorder {
+  public:
+    explicit resume_latency_recorder(latency_histogram &histogram) noexcept
+        : histogram_(histogram), overhead_(overhead()), previous_(resume_timing::local()) {
+        auto &timing = resume_timing::local();
+        timing.sink = &record;
+        timing.context = this;
+    }
+
+    resume_latency_recorder(const resume_latency_recorder &) = delete;
+    resume_latency_recorder &operator=(const resume_latency_recorder &) = delete;
+
+    ~resume_latency_recorder() {
+        resume_timing::local() = previous_;
+    }
+
+    // Median duration of an empty timed section, in ticks: what each
+    // sample is corrected by.
+    static std::uint64_t overhead() noexcept {
+        static thread_local const std::uint64_t ticks = [] {
+            std::array<std::uint64_t, 1001> samples;
+            for (auto &sample : samples) {
+                const auto start = resume_timing::now();
+                sample = resume_timing::now() - start;
+            }
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        }();
+        return ticks;
+    }
+
+  private:
+    static void record(void *context, std::uint64_t ticks) noexcept {
+        auto &self = *static_cast<resume_latency_recorder *>(context);
+        self.histogram_.record(ticks > self.overhead_ ? ticks - self.overhead_ : 0);
+    }
+
+    latency_histogram &histogram_;
+    const std::uint64_t overhead_;
+    const resume_timing previous_;
+};
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////
+// Records of a file, yielded as views into a memory mapping of it.
+//
+//   for (std::string_view line : mapped_records("app.log"))
+//
+// Records are delimited by newlines (the last one may lack it), or
+// prefixed by their length as a 32-bit little-endian integer. Nothing is
+// copied: each view points into the mapping, and is only valid until the
+// generator is resumed.
+//
+// With a window size, the file is mapped one window at a time instead of
+// as a whole, for files larger than the address space to spare. A window
+// is remapped from the first incomplete record on, and grown when a
+// single record does not fit in it.
+//
+// POSIX only.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class record_framing {
+    newline,
+    length_prefixed,
+};
+
+namespace detail {
+
+class mapped_file {
+  public:
+    explicit mapped_file(const char *path) : fd_(::open(path, O_RDONLY | O_CLOEXEC)) {
+        if (fd_ < 0)
+            throw std::system_error(errno, std::system_category(), "open");
+        struct stat st;
+        if (::fstat(fd_, &st) < 0) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::system_category(), "fstat");
+        }
+        size_ = std::uint64_t(st.st_size);
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    ~mapped_file() {
+        ::close(fd_);
+    }
+
+    std::uint64_t size() const noexcept {
+        return size_;
+    }
+
+    int fd() const noexcept {
+        return fd_;
+    }
+
+  private:
+    int fd_;
+    std::uint64_t size_ = 0;
+};
+
+// Read-only mapping of [offset, offset + size) of a file, read ahead
+// aggressively by the kernel and dropped behind.
+class mapped_window {
+  public:
+    mapped_window(int fd, std::uint64_t offset, std::size_t size) : size_(size) {
+        void *p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, off_t(offset));
+        if (p == MAP_FAILED)
+            throw std::system_error(errno, std::system_category(), "mmap");
+        data_ = static_cast<const char *>(p);
+        ::madvise(p, size, MADV_SEQUENTIAL);
+    }
+
+    mapped_window(const mapped_window &) = delete;
+    mapped_window &operator=(const mapped_window &) = delete;
+
+    ~mapped_window() {
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+
+    const char *begin() const noexcept {
+        return data_;
+    }
+    const char *end() const noexcept {
+        return data_ + size_;
+    }
+
+  private:
+    const char *data_;
+    std::size_t size_;
+};
+
+inline std::uint32_t load_le32(const char *p) noexcept {
+    const auto *b = reinterpret_cast<const unsigned char *>(p);
+    return std::uint32_t(b[0]) | std::uint32_t(b[1]) << 8 | std::uint32_t(b[2]) << 16 |
+           std::uint32_t(b[3]) << 24;
+}
+
+} // namespace detail
+
+// `window` is rounded up to the page size; 0 maps the whole file at once.
+inline simple::generator<std::string_view>
+mapped_records(const char *path, record_framing framing = record_framing::newline, std::size_t window = 0) {
+    detail::mapped_file file(path);
+    const std::uint64_t size = file.size();
+    const std::uint64_t page = std::uint64_t(::sysconf(_SC_PAGESIZE));
+    std::uint64_t span = window == 0 ? size : (window + page - 1) / page * page;
+
+    // Start of the first record not yielded yet.
+    std::uint64_t offset = 0;
+    while (offset < size) {
+        // Mappings start on a page boundary.
+        const std::uint64_t base = offset / page * page;
+        const std::uint64_t length = std::min(span, size - base);
+        const bool last = base + length == size;
+        detail::mapped_window mapping(file.fd(), base, std::size_t(length));
+
+        const char *p = mapping.begin() + (offset - base);
+        const char *const end = mapping.end();
+        if (framing == record_framing::newline) {
+            // memchr is vectorized by the C library.
+            while (p != end) {
+                const auto *newline = static_cast<const char *>(std::memchr(p, '\n', std::size_t(end - p)));
+                if (!newline) {
+                    if (last) {
+                        co_yield std::string_view(p, std::size_t(end - p));
+                        p = end;
+                    }
+                    break;
+                }
+                co_yield std::string_view(p, std::size_t(newline - p));
+                p = newline + 1;
+            }
+        } else {
+            while (end - p >= 4) {
+                const std::uint32_t n = detail::load_le32(p);
+                if (std::uint64_t(end - p - 4) < n)
+                    break;
+                co_yield std::string_view(p + 4, n);
+                p += 4 + std::size_t(n);
+            }
+            if (last && p != end)
+                throw std::runtime_error("mapped_records: truncated record");
+        }
+
+        const std::uint64_t next = base + std::uint64_t(p - mapping.begin());
+        // Not even one record fits in the window.
+        if (next == offset && !last)
+            span *= 2;
+        offset = next;
+    }
+}
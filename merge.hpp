@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////
+// K-way merge of sorted generators.
+//
+//   for (auto &&v : merge(std::move(shards)))        // std::vector of generators
+//   for (auto &&v : merge(std::move(a), std::move(b), std::move(c)))
+//
+// The inputs are merged with a loser tree: after the smallest head is
+// consumed, only the path from its leaf to the root is replayed, with one
+// comparison per level and no sift. The nodes hold stream indices in one
+// array, and the heads of the streams are kept in another, apart from the
+// generators, so that a replay touches two small contiguous arrays instead
+// of chasing iterators into each generator's frame.
+//
+// The merge is stable: equal values come out in the order of their
+// streams. Merging simple::generators gives a simple::generator, and
+// recursive::generators a recursive::generator, of the same reference
+// type. Values are forwarded as the inputs yield them; a reference is
+// valid until the merge is resumed.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Tournament of `size` streams for the smallest head, by `Compare`.
+// Exhausted streams lose to all others.
+template <typename Ref, typename Compare = std::less<>>
+class loser_tree {
+  public:
+    explicit loser_tree(std::size_t size, Compare comp = {})
+        : size_(size), comp_(std::move(comp)), nodes_(new std::uint32_t[size ? size : 1]),
+          leaves_(new leaf[size]) {
+    }
+
+    loser_tree(const loser_tree &) = delete;
+    loser_tree &operator=(const loser_tree &) = delete;
+
+    ~loser_tree() {
+        for (std::size_t i = 0; i < size_; ++i)
+            leaves_[i].clear();
+    }
+
+    // Sets the head of stream i, before build() or after a pop().
+    void set(std::size_t i, Ref value) {
+        leaves_[i].set(static_cast<Ref &&>(value));
+    }
+
+    // Plays the whole tournament, once the heads are set.
+    void build() {
+        if (size_ != 0)
+            nodes_[0] = play(1);
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0 || !leaves_[nodes_[0]].live_;
+    }
+
+    // Stream with the smallest head, which is only valid if !empty().
+    std::size_t top() const noexcept {
+        return nodes_[0];
+    }
+
+    Ref top_value() {
+        return std::move(leaves_[nodes_[0]].head_).get();
+    }
+
+    // Drops the head of the top stream. Its next head, if any, is set()
+    // before replay().
+    void pop() noexcept {
+        leaves_[nodes_[0]].clear();
+    }
+
+    // Replays the matches of the top stream, from its leaf up.
+    void replay() {
+        auto winner = nodes_[0];
+        for (std::size_t node = (size_ + winner) / 2; node != 0; node /= 2) {
+            const auto challenger = nodes_[node];
+            const bool swap = beats(challenger, winner);
+            nodes_[node] = swap ? winner : challenger;
+            winner = swap ? challenger : winner;
+        }
+        nodes_[0] = winner;
+    }
+
+  private:
+    struct leaf {
+        void set(Ref &&value) {
+            head_.construct(static_cast<Ref &&>(value));
+            live_ = true;
+        }
+        void clear() noexcept {
+            if (live_)
+                head_.destruct();
+            live_ = false;
+        }
+
+        __manual_lifetime<Ref> head_;
+        bool live_ = false;
+    };
+
+    // Ties go to the first stream, for the merge to be stable.
+    bool beats(std::uint32_t a, std::uint32_t b) {
+        const leaf &la = leaves_[a];
+        const leaf &lb = leaves_[b];
+        if (!la.live_)
+            return false;
+        if (!lb.live_)
+            return true;
+        // One comparison: the first stream wins unless the other one's
+        // head is smaller, the second only if its head is smaller. The
+        // operands are selected rather than branched on, so that the
+        // comparison of scalars compiles to conditional moves.
+        const bool first = a < b;
+        const leaf &x = first ? lb : la;
+        const leaf &y = first ? la : lb;
+        return first != bool(std::invoke(comp_, x.head_.get(), y.head_.get()));
+    }
+
+    // Nodes 1 to size - 1 are matches, whose children are 2n and 2n + 1;
+    // nodes size to 2 * size - 1 are the leaves. Records the loser of
+    // each match and returns the winner.
+    std::uint32_t play(std::size_t node) {
+        if (node >= size_)
+            return std::uint32_t(node - size_);
+        auto left = play(2 * node);
+        auto right = play(2 * node + 1);
+        if (beats(right, left))
+            std::swap(left, right);
+        nodes_[node] = right;
+        return left;
+    }
+
+    std::size_t size_;
+    Compare comp_;
+    // nodes_[0] is the winner, the others the losers of the matches.
+    std::unique_ptr<std::uint32_t[]> nodes_;
+    std::unique_ptr<leaf[]> leaves_;
+};
+
+namespace detail {
+
+template <typename Generator>
+struct merged;
+
+template <typename Ref, typename Value, typename Alloc, typename Policy>
+struct merged<simple::generator<Ref, Value, Alloc, Policy>> {
+    using type = simple::generator<Ref, Value>;
+};
+
+template <typename Ref, typename Value, typename Alloc, typename Policy>
+struct merged<recursive::generator<Ref, Value, Alloc, Policy>> {
+    using type = recursive::generator<Ref, Value>;
+};
+
+} // namespace detail
+
+template <typename Generator, typename Compare = std::less<>>
+typename detail::merged<Generator>::type merge(std::vector<Generator> gens, Compare comp = {}) {
+    using iterator = typename Generator::iterator;
+    using reference = typename iterator::reference;
+
+    std::vector<iterator> its;
+    its.reserve(gens.size());
+    loser_tree<reference, Compare> tree(gens.size(), std::move(comp));
+    for (std::size_t i = 0; i < gens.size(); ++i) {
+        its.push_back(gens[i].begin());
+        if (its[i] != gens[i].end())
+            tree.set(i, *its[i]);
+    }
+    tree.build();
+
+    while (!tree.empty()) {
+        const std::size_t i = tree.top();
+        co_yield tree.top_value();
+        tree.pop();
+        ++its[i];
+        if (its[i] != gens[i].end())
+            tree.set(i, *its[i]);
+        tree.replay();
+    }
+}
+
+template <typename Generator, typename... Generators>
+requires(std::same_as<Generator, Generators> &&...) typename detail::merged<Generator>::type
+    merge(Generator first, Generators... rest) {
+    std::vector<Generator> gens;
+    gens.reserve(1 + sizeof...(rest));
+    gens.push_back(std::move(first));
+    (gens.push_back(std::move(rest)), ...);
+    return merge(std::move(gens));
+}
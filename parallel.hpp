@@ -0,0 +1,627 @@
+////////////////////////////////////////////////////////////////
+// Parallel consumption of generators.
+//
+// parallel_traverse walks a tree of recursive::generator on several
+// threads: every generator yielded with elements_of() becomes a task
+// that idle workers can steal, instead of being resumed nested. The
+// generators need spawn_policy::spawnable.
+//
+// parallel_for_each and parallel_transform spread the values of a single
+// generator over several threads: the calling thread runs the generator
+// and hands its values out by batches to the threads of a worker_pool.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Chase-Lev work-stealing deque of pointers ("Correct and Efficient
+// Work-Stealing for Weak Memory Models", Lê et al., PPoPP 2013).
+// The owner pushes and pops at the bottom, thieves steal from the top.
+// Buffers replaced when growing are kept until the deque is destroyed,
+// as thieves may still be reading them.
+class work_stealing_deque {
+    struct buffer {
+        explicit buffer(std::int64_t capacity)
+            : capacity_(capacity), slots_(new std::atomic<void *>[capacity]) {
+        }
+
+        void *get(std::int64_t i) const noexcept {
+            return slots_[i & (capacity_ - 1)].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, void *p) noexcept {
+            slots_[i & (capacity_ - 1)].store(p, std::memory_order_relaxed);
+        }
+
+        const std::int64_t capacity_;
+        std::unique_ptr<std::atomic<void *>[]> slots_;
+    };
+
+  public:
+    explicit work_stealing_deque(std::int64_t capacity = 256) {
+        buffers_.push_back(std::make_unique<buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque &) = delete;
+    work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+    // Owner only.
+    void push(void *p) {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        buffer *a = buffer_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity_ - 1)
+            a = grow(a, t, b);
+        a->put(b, p);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Returns nullptr when empty.
+    void *pop() noexcept {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        buffer *a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        void *p = a->get(b);
+        if (t == b) {
+            // Last element: race against thieves.
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                p = nullptr;
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return p;
+    }
+
+    // Any thread. Returns nullptr when empty or when losing a race.
+    void *steal() noexcept {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        buffer *a = buffer_.load(std::memory_order_acquire);
+        void *p = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+            return nullptr;
+        return p;
+    }
+
+  private:
+    buffer *grow(buffer *a, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<buffer>(a->capacity_ * 2);
+        for (std::int64_t i = t; i < b; ++i)
+            bigger->put(i, a->get(i));
+        buffers_.push_back(std::move(bigger));
+        buffer_.store(buffers_.back().get(), std::memory_order_release);
+        return buffers_.back().get();
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<buffer *> buffer_;
+    std::vector<std::unique_ptr<buffer>> buffers_;
+};
+
+// Bounded multi-producer multi-consumer queue of pointers (Dmitry
+// Vyukov's): every slot carries a sequence number telling whether it is
+// free for the push, or ready for the pop, of the current lap.
+class mpmc_queue {
+    struct slot {
+        std::atomic<std::size_t> sequence_;
+        void *value_;
+    };
+
+  public:
+    // The capacity is rounded up to a power of two.
+    explicit mpmc_queue(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        mask_ = size - 1;
+        slots_.reset(new slot[size]);
+        for (std::size_t i = 0; i < size; ++i)
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    mpmc_queue(const mpmc_queue &) = delete;
+    mpmc_queue &operator=(const mpmc_queue &) = delete;
+
+    // Returns false when full.
+    bool push(void *p) noexcept {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot &s = slots_[pos & mask_];
+            const std::size_t sequence = s.sequence_.load(std::memory_order_acquire);
+            const auto lag = std::intptr_t(sequence) - std::intptr_t(pos);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.value_ = p;
+                    s.sequence_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns nullptr when empty.
+    void *pop() noexcept {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot &s = slots_[pos & mask_];
+            const std::size_t sequence = s.sequence_.load(std::memory_order_acquire);
+            const auto lag = std::intptr_t(sequence) - std::intptr_t(pos + 1);
+            if (lag == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    void *p = s.value_;
+                    s.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+                    return p;
+                }
+            } else if (lag < 0) {
+                return nullptr;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+  private:
+    std::size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+};
+
+// Threads kept across calls of parallel_for_each and parallel_transform,
+// so that they are not started and joined on every call. The calling
+// thread takes part as worker 0: a pool of `threads` workers starts
+// threads - 1 threads, which sleep between jobs.
+class worker_pool {
+  public:
+    using job = void (*)(void *context, std::size_t index) noexcept;
+
+    explicit worker_pool(std::size_t threads) : size_(threads == 0 ? 1 : threads) {
+        try {
+            for (std::size_t i = 1; i < size_; ++i)
+                threads_.emplace_back([this, i] { loop(i); });
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool &operator=(const worker_pool &) = delete;
+
+    ~worker_pool() {
+        stop();
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    // Calls f(context, i) on every worker i, the calling thread being
+    // worker 0, and returns once all of them returned. One job at a time.
+    void run(job f, void *context) noexcept {
+        job_ = f;
+        context_ = context;
+        pending_.store(size_ - 1, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        generation_.notify_all();
+        f(context, 0);
+        for (;;) {
+            const std::size_t pending = pending_.load(std::memory_order_acquire);
+            if (pending == 0)
+                return;
+            pending_.wait(pending, std::memory_order_acquire);
+        }
+    }
+
+  private:
+    void loop(std::size_t index) noexcept {
+        std::uint64_t seen = 0;
+        for (;;) {
+            generation_.wait(seen, std::memory_order_acquire);
+            seen = generation_.load(std::memory_order_acquire);
+            if (stopping_)
+                return;
+            job_(context_, index);
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                pending_.notify_one();
+        }
+    }
+
+    void stop() noexcept {
+        stopping_ = true;
+        generation_.fetch_add(1, std::memory_order_release);
+        generation_.notify_all();
+        for (auto &t : threads_)
+            t.join();
+    }
+
+    const std::size_t size_;
+    std::vector<std::thread> threads_;
+    // Published by the release increment of generation_.
+    job job_ = nullptr;
+    void *context_ = nullptr;
+    bool stopping_ = false;
+    std::atomic<std::uint64_t> generation_{0};
+    // Workers other than the calling thread still running the job.
+    std::atomic<std::size_t> pending_{0};
+};
+
+namespace detail {
+
+template <typename Generator, typename Sink>
+class traversal {
+    class worker final : public Generator::spawner {
+      public:
+        worker(traversal &owner, const Sink &sink) : owner_(owner), sink_(sink) {
+        }
+
+        void spawn(Generator &&g) override {
+            owner_.pending_.fetch_add(1, std::memory_order_relaxed);
+            deque_.push(this->release(g));
+        }
+
+        void run(std::size_t index) {
+            std::size_t victim = index;
+            while (owner_.pending_.load(std::memory_order_acquire) != 0) {
+                void *task = deque_.pop();
+                for (std::size_t i = 1; !task && i < owner_.workers_.size(); ++i) {
+                    victim = victim + 1 == owner_.workers_.size() ? 0 : victim + 1;
+                    if (victim != index)
+                        task = owner_.workers_[victim]->deque_.steal();
+                }
+                if (!task) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                execute(task);
+                owner_.pending_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+
+        void execute(void *task) {
+            Generator g = this->adopt(task);
+            if (owner_.failed_.load(std::memory_order_relaxed))
+                return;
+            g.set_spawner(this);
+            try {
+                for (auto &&v : g)
+                    sink_(std::forward<decltype(v)>(v));
+            } catch (...) {
+                owner_.fail(std::current_exception());
+            }
+        }
+
+        traversal &owner_;
+        Sink sink_;
+        work_stealing_deque deque_;
+    };
+
+  public:
+    traversal(std::size_t threads, const Sink &sink) {
+        if (threads == 0)
+            threads = 1;
+        for (std::size_t i = 0; i < threads; ++i)
+            workers_.push_back(std::make_unique<worker>(*this, sink));
+    }
+
+    std::vector<Sink> run(Generator root) {
+        workers_[0]->spawn(std::move(root));
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < workers_.size(); ++i)
+            threads.emplace_back([this, i] { workers_[i]->run(i); });
+        workers_[0]->run(0);
+        for (auto &t : threads)
+            t.join();
+        if (exception_)
+            std::rethrow_exception(exception_);
+        std::vector<Sink> sinks;
+        for (auto &w : workers_)
+            sinks.push_back(std::move(w->sink_));
+        return sinks;
+    }
+
+  private:
+    void fail(std::exception_ptr e) {
+        std::lock_guard lock(mutex_);
+        if (!exception_)
+            exception_ = std::move(e);
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    std::vector<std::unique_ptr<worker>> workers_;
+    // Tasks spawned and not yet completed.
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<bool> failed_{false};
+    std::mutex mutex_;
+    std::exception_ptr exception_;
+};
+
+// Values of a generator processed by batches on a worker_pool, each
+// worker calling its own copy of `fn`. The calling thread is worker 0:
+// it runs the generator, fills the batches and, when none is free,
+// processes one itself. When Ordered, the results of fn are handed to the
+// sink by the calling thread, batch after batch in the order they were
+// filled.
+template <typename Generator, typename F, typename Sink, bool Ordered>
+class fan_out {
+    using value_type = typename Generator::iterator::value_type;
+    using result_type = std::invoke_result_t<F &, value_type &&>;
+
+    struct batch {
+        std::vector<value_type> items_;
+        [[no_unique_address]] std::conditional_t<Ordered, std::vector<result_type>, __empty> results_;
+        // Ordered only: set once results_ is complete.
+        std::atomic<bool> done_{false};
+    };
+
+    struct alignas(64) worker {
+        F fn_;
+    };
+
+  public:
+    fan_out(const F &fn, std::size_t threads, std::size_t batch_size)
+        : threads_(threads), batchSize_(batch_size == 0 ? 1 : batch_size), work_(2 * threads_),
+          free_(2 * threads_) {
+        for (std::size_t i = 0; i < threads_; ++i)
+            workers_.push_back(worker{fn});
+        // As many batches as the queues can hold, so that pushes never fail.
+        for (std::size_t i = 0; i < 2 * threads_; ++i) {
+            batches_.push_back(std::make_unique<batch>());
+            batches_.back()->items_.reserve(batchSize_);
+            free_.push(batches_.back().get());
+        }
+        inFlight_.resize(batches_.size());
+    }
+
+    void run(worker_pool &pool, Generator &gen, Sink &sink) {
+        gen_ = &gen;
+        sink_ = &sink;
+        pool.run(&fan_out::entry, this);
+        if constexpr (Ordered) {
+            if (!exception_)
+                commit();
+        }
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+    std::vector<F> functions() {
+        std::vector<F> fns;
+        for (auto &w : workers_)
+            fns.push_back(std::move(w.fn_));
+        return fns;
+    }
+
+  private:
+    static void entry(void *self, std::size_t index) noexcept {
+        auto &f = *static_cast<fan_out *>(self);
+        if (index == 0)
+            f.lead();
+        else
+            f.work(index);
+    }
+
+    // Worker 0: produces, then helps with the last batches.
+    void lead() noexcept {
+        try {
+            produce();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        closed_.store(true, std::memory_order_release);
+        while (auto *b = static_cast<batch *>(work_.pop()))
+            execute(0, *b);
+    }
+
+    void produce() {
+        auto &gen = *gen_;
+        for (auto it = gen.begin(); it != gen.end();) {
+            batch &b = acquire();
+            if (failed_.load(std::memory_order_relaxed)) {
+                free_.push(&b);
+                return;
+            }
+            for (; b.items_.size() < batchSize_ && it != gen.end(); ++it)
+                b.items_.emplace_back(*it);
+            if constexpr (Ordered) {
+                b.done_.store(false, std::memory_order_relaxed);
+                inFlight_[inFlightTail_++ % inFlight_.size()] = &b;
+            }
+            work_.push(&b);
+            if constexpr (Ordered)
+                commit();
+        }
+    }
+
+    // A free batch; while there is none, commits finished batches or
+    // processes one.
+    batch &acquire() {
+        for (;;) {
+            if (auto *b = static_cast<batch *>(free_.pop()))
+                return *b;
+            if constexpr (Ordered) {
+                if (commit())
+                    continue;
+            }
+            if (auto *b = static_cast<batch *>(work_.pop())) {
+                execute(0, *b);
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Hands the results of the oldest batches to the sink, as long as they
+    // are done, unless a worker failed. Returns whether any batch was freed.
+    bool commit() {
+        bool freed = false;
+        while (inFlightHead_ != inFlightTail_) {
+            batch &b = *inFlight_[inFlightHead_ % inFlight_.size()];
+            if (!b.done_.load(std::memory_order_acquire))
+                break;
+            ++inFlightHead_;
+            if (!failed_.load(std::memory_order_relaxed)) {
+                for (auto &r : b.results_)
+                    (*sink_)(std::move(r));
+            }
+            b.results_.clear();
+            free_.push(&b);
+            freed = true;
+        }
+        return freed;
+    }
+
+    void work(std::size_t index) noexcept {
+        for (;;) {
+            if (auto *b = static_cast<batch *>(work_.pop())) {
+                execute(index, *b);
+            } else if (closed_.load(std::memory_order_acquire)) {
+                // Pushes all happen before closing: one last look.
+                b = static_cast<batch *>(work_.pop());
+                if (!b)
+                    return;
+                execute(index, *b);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void execute(std::size_t index, batch &b) noexcept {
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                auto &fn = workers_[index].fn_;
+                for (auto &item : b.items_) {
+                    if constexpr (Ordered)
+                        b.results_.push_back(fn(std::move(item)));
+                    else
+                        fn(std::move(item));
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+        b.items_.clear();
+        if constexpr (Ordered)
+            b.done_.store(true, std::memory_order_release);
+        else
+            free_.push(&b);
+    }
+
+    void fail(std::exception_ptr e) {
+        std::lock_guard lock(mutex_);
+        if (!exception_)
+            exception_ = std::move(e);
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    const std::size_t threads_;
+    const std::size_t batchSize_;
+    std::vector<worker> workers_;
+    std::vector<std::unique_ptr<batch>> batches_;
+    Generator *gen_ = nullptr;
+    Sink *sink_ = nullptr;
+    // Filled batches, and empty ones.
+    mpmc_queue work_;
+    mpmc_queue free_;
+    // Calling thread only, when Ordered: the batches handed out and not
+    // yet committed, oldest first.
+    std::vector<batch *> inFlight_;
+    std::size_t inFlightHead_ = 0;
+    std::size_t inFlightTail_ = 0;
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> failed_{false};
+    std::mutex mutex_;
+    std::exception_ptr exception_;
+};
+
+} // namespace detail
+
+// Consumes all the values of a tree of recursive::generator on `threads`
+// threads, the calling thread included, in no particular order.
+//
+// Each worker hands the values to its own copy of `sink`, and the sinks
+// are returned once the whole tree has been consumed, for the caller to
+// combine. The first exception escaping a generator is rethrown once all
+// the workers are done; the generators not started by then are destroyed
+// without being run.
+//
+// Frames are destroyed on other threads than the ones that created them,
+// and in no particular order, so the generators must not use an allocator
+// requiring frames to be freed in LIFO order, such as
+// frame_arena_allocator or thread_arena_allocator.
+template <typename Ref, typename Value, typename Alloc, typename Policy, typename Sink>
+std::vector<Sink> parallel_traverse(recursive::generator<Ref, Value, Alloc, Policy> root,
+                                    std::size_t threads, const Sink &sink) {
+    static_assert(Policy::spawn == spawn_policy::spawnable, "parallel_traverse requires spawn_policy::spawnable");
+    detail::traversal<recursive::generator<Ref, Value, Alloc, Policy>, Sink> t(threads, sink);
+    return t.run(std::move(root));
+}
+
+// Calls `fn` on all the values of `gen` on the threads of `pool`, the
+// calling thread included, in no particular order.
+//
+// The calling thread alone runs the generator: it moves its values into
+// batches of `batch` values, which the workers take from a lock-free
+// queue. Each worker calls its own copy of `fn`, and the copies are
+// returned once all the values have been processed, for the caller to
+// combine. The first exception escaping the generator or `fn` is
+// rethrown once all the workers are done; the values not processed by
+// then are dropped.
+template <typename Generator, typename F>
+std::vector<F> parallel_for_each(Generator gen, const F &fn, worker_pool &pool, std::size_t batch = 256) {
+    detail::fan_out<Generator, F, __empty, false> f(fn, pool.size(), batch);
+    __empty none;
+    f.run(pool, gen, none);
+    return f.functions();
+}
+
+// Same, on `threads` threads started for this call only.
+template <typename Generator, typename F>
+std::vector<F> parallel_for_each(Generator gen, const F &fn, std::size_t threads, std::size_t batch = 256) {
+    worker_pool pool(threads);
+    return parallel_for_each(std::move(gen), fn, pool, batch);
+}
+
+// Same as parallel_for_each, with the results of `fn` passed to `sink`
+// on the calling thread, in the order of the values they were computed
+// from. Returns the sink.
+template <typename Generator, typename F, typename Sink>
+Sink parallel_transform(Generator gen, const F &fn, Sink sink, worker_pool &pool, std::size_t batch = 256) {
+    detail::fan_out<Generator, F, Sink, true> f(fn, pool.size(), batch);
+    f.run(pool, gen, sink);
+    return sink;
+}
+
+template <typename Generator, typename F, typename Sink>
+Sink parallel_transform(Generator gen, const F &fn, Sink sink, std::size_t threads, std::size_t batch = 256) {
+    worker_pool pool(threads);
+    return parallel_transform(std::move(gen), fn, std::move(sink), pool, batch);
+}
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////
+// Hardware performance counters of the calling thread, read through
+// Linux perf_event_open.
+//
+// Counters that cannot be opened (no PMU, perf_event_paranoid, container
+// restrictions...) are left out, with one warning per event and process;
+// on other systems no counter is ever available.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace perf {
+
+struct event {
+    const char *name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+#if defined(__linux__)
+inline constexpr event events[] = {
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"LLC-load-misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+#else
+inline constexpr event events[] = {
+    {"instructions", 0, 0},
+    {"cycles", 0, 0},
+    {"branch-misses", 0, 0},
+    {"L1-dcache-load-misses", 0, 0},
+    {"LLC-load-misses", 0, 0},
+};
+#endif
+
+// Events selected for measurement, as indices into `events`.
+inline std::vector<std::size_t> &selected_events() {
+    static std::vector<std::size_t> selection;
+    return selection;
+}
+
+// Selects events from a comma-separated list of names, "all" standing for
+// every known event. Returns false on an unknown name.
+inline bool select_events(std::string_view list) {
+    auto &selection = selected_events();
+    selection.clear();
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        const auto name = list.substr(0, comma);
+        list = comma == list.npos ? std::string_view{} : list.substr(comma + 1);
+        if (name.empty())
+            continue;
+        bool found = false;
+        for (std::size_t i = 0; i < std::size(events); ++i) {
+            if (name == "all" || name == events[i].name) {
+                selection.push_back(i);
+                found = true;
+            }
+        }
+        if (!found) {
+            std::fprintf(stderr, "unknown perf event '%.*s'\n", int(name.size()), name.data());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Group of counters for the selected events, counting user-space
+// execution of the calling thread between start() and stop().
+class counters {
+  public:
+    counters() {
+#if defined(__linux__)
+        for (std::size_t index : selected_events())
+            open(index);
+#endif
+    }
+
+    counters(const counters &) = delete;
+    counters &operator=(const counters &) = delete;
+
+    ~counters() {
+#if defined(__linux__)
+        for (int fd : fds_)
+            ::close(fd);
+#endif
+    }
+
+    void start() noexcept {
+#if defined(__linux__)
+        if (!fds_.empty()) {
+            ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    void stop() noexcept {
+#if defined(__linux__)
+        if (!fds_.empty())
+            ::ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    struct value {
+        const char *name;
+        double count;
+    };
+
+    // Counts since start(), scaled up when the group was multiplexed
+    // with other events and only ran part of the time. A group that never
+    // got onto the PMU has no count to scale, and reads as no counters.
+    std::vector<value> read() const {
+        std::vector<value> values;
+#if defined(__linux__)
+        if (fds_.empty())
+            return values;
+        // nr, time_enabled, time_running, then one value per counter.
+        std::vector<std::uint64_t> buffer(3 + fds_.size());
+        const auto bytes = buffer.size() * sizeof(std::uint64_t);
+        if (::read(fds_[0], buffer.data(), bytes) != static_cast<ssize_t>(bytes))
+            return values;
+        if (buffer[2] == 0)
+            return values;
+        const double scale = double(buffer[1]) / double(buffer[2]);
+        for (std::size_t i = 0; i < fds_.size(); ++i)
+            values.push_back({events[indices_[i]].name, double(buffer[3 + i]) * scale});
+#endif
+        return values;
+    }
+
+  private:
+#if defined(__linux__)
+    void open(std::size_t index) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[index].type;
+        attr.config = events[index].config;
+        attr.disabled = fds_.empty();
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const int leader = fds_.empty() ? -1 : fds_[0];
+        const int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            warn_once(index, errno);
+            return;
+        }
+        fds_.push_back(fd);
+        indices_.push_back(index);
+    }
+
+    static void warn_once(std::size_t index, int error) {
+        static std::atomic<bool> warned[std::size(events)] = {};
+        if (!warned[index].exchange(true, std::memory_order_relaxed))
+            std::fprintf(stderr, "perf event '%s' unavailable: %s\n",
+                         events[index].name, std::strerror(error));
+    }
+
+    std::vector<int> fds_;
+    std::vector<std::size_t> indices_;
+#endif
+};
+
+} // namespace perf
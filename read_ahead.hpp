@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////
+// Runs a generator on a dedicated thread, reading ahead into a
+// single-producer/single-consumer ring buffer.
+//
+// The consumer iterates over a read_ahead exactly as it would over the
+// generator itself. Values are moved into the ring as they are produced;
+// an exception escaping the generator is rethrown to the consumer after
+// the values produced before it, and destroying the read_ahead before the
+// end cancels the producer.
+
+#pragma once
+
+#include <generator.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+template <typename Generator>
+class read_ahead {
+    using value_type_ = typename Generator::iterator::value_type;
+    static_assert(std::is_nothrow_destructible_v<value_type_>);
+
+    // Set in tail_ once the producer is done, in head_ once the consumer
+    // gave up.
+    static constexpr std::size_t flag = std::size_t(1) << (sizeof(std::size_t) * 8 - 1);
+
+    // Rounds up to a power of two, so that indices can be masked.
+    static std::size_t ring_size(std::size_t capacity) noexcept {
+        std::size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        return size;
+    }
+
+  public:
+    // `batch` values are produced (resp. consumed) before the other side
+    // is told about them, which keeps the two threads from bouncing the
+    // indices' cache lines on every value.
+    explicit read_ahead(Generator gen, std::size_t capacity = 1024,
+                        std::size_t batch = 64)
+        : gen_(std::move(gen)), capacity_(ring_size(capacity)),
+          batch_(batch == 0 ? 1 : batch < capacity_ ? batch : capacity_),
+          slots_(new __manual_lifetime<value_type_>[capacity_]),
+          thread_([this] { produce(); }) {
+    }
+
+    read_ahead(const read_ahead &) = delete;
+    read_ahead &operator=(const read_ahead &) = delete;
+
+    ~read_ahead() {
+        head_.fetch_or(flag, std::memory_order_release);
+        head_.notify_one();
+        thread_.join();
+        const std::size_t tail = tail_.load(std::memory_order_acquire) & ~flag;
+        for (std::size_t i = consumerHead_; i != tail; ++i)
+            slots_[i & (capacity_ - 1)].destruct();
+    }
+
+    struct sentinel {};
+
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = value_type_;
+        using reference = value_type_ &;
+        using pointer = value_type_ *;
+
+        iterator() noexcept = default;
+        iterator(const iterator &) = delete;
+
+        iterator(iterator &&o) noexcept : owner_(std::exchange(o.owner_, {})) {
+        }
+
+        iterator &operator=(iterator &&o) {
+            std::swap(owner_, o.owner_);
+            return *this;
+        }
+
+        friend bool operator==(const iterator &it, sentinel) noexcept {
+            return it.done();
+        }
+
+        iterator &operator++() {
+            owner_->pop();
+            return *this;
+        }
+        void operator++(int) {
+            (void)operator++();
+        }
+
+        reference operator*() const noexcept {
+            return owner_->front();
+        }
+
+        pointer operator->() const noexcept {
+            return std::addressof(operator*());
+        }
+
+      private:
+        friend read_ahead;
+        explicit iterator(read_ahead *owner) noexcept : owner_(owner) {
+        }
+
+        bool done() const noexcept {
+            return !owner_ || owner_->done_;
+        }
+
+        read_ahead *owner_ = nullptr;
+    };
+
+    iterator begin() {
+        wait_for_value();
+        return iterator{this};
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+
+  private:
+    void produce() noexcept {
+        std::size_t tail = 0;
+        try {
+            std::size_t head = 0;
+            std::size_t unpublished = 0;
+            for (auto &&v : gen_) {
+                if (tail - head == capacity_) {
+                    publish(tail);
+                    unpublished = 0;
+                    head = wait_for_space(tail);
+                    if (head & flag)
+                        break;
+                }
+                slots_[tail & (capacity_ - 1)].construct(std::forward<decltype(v)>(v));
+                ++tail;
+                if (++unpublished == batch_) {
+                    publish(tail);
+                    unpublished = 0;
+                    if (head_.load(std::memory_order_relaxed) & flag)
+                        break;
+                }
+            }
+        } catch (...) {
+            exception_ = std::current_exception();
+        }
+        tail_.store(tail | flag, std::memory_order_release);
+        tail_.notify_one();
+    }
+
+    void publish(std::size_t tail) noexcept {
+        tail_.store(tail, std::memory_order_release);
+        tail_.notify_one();
+    }
+
+    // Waits until the consumer made some room, or gave up.
+    std::size_t wait_for_space(std::size_t tail) noexcept {
+        for (;;) {
+            const std::size_t head = head_.load(std::memory_order_acquire);
+            if ((head & flag) || tail - head < capacity_)
+                return head;
+            head_.wait(head, std::memory_order_acquire);
+        }
+    }
+
+    value_type_ &front() noexcept {
+        return slots_[consumerHead_ & (capacity_ - 1)].get();
+    }
+
+    void pop() {
+        slots_[consumerHead_ & (capacity_ - 1)].destruct();
+        ++consumerHead_;
+        if (++unreleased_ == batch_) {
+            release();
+        }
+        wait_for_value();
+    }
+
+    void release() noexcept {
+        unreleased_ = 0;
+        head_.store(consumerHead_, std::memory_order_release);
+        head_.notify_one();
+    }
+
+    // Waits until a value is available at consumerHead_, or the producer
+    // is done, in which case its exception (if any) is rethrown.
+    void wait_for_value() {
+        if (consumerHead_ != consumerTail_)
+            return;
+        release();
+        for (;;) {
+            const std::size_t tail = tail_.load(std::memory_order_acquire);
+            consumerTail_ = tail & ~flag;
+            if (consumerHead_ != consumerTail_)
+                return;
+            if (tail & flag) {
+                done_ = true;
+                if (exception_)
+                    std::rethrow_exception(std::exchange(exception_, nullptr));
+                return;
+            }
+            tail_.wait(tail, std::memory_order_acquire);
+        }
+    }
+
+    Generator gen_;
+    const std::size_t capacity_;
+    const std::size_t batch_;
+    std::unique_ptr<__manual_lifetime<value_type_>[]> slots_;
+    std::exception_ptr exception_;
+
+    // Published by the producer: number of values produced.
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    // Published by the consumer: number of values consumed.
+    alignas(64) std::atomic<std::size_t> head_{0};
+
+    // Consumer side.
+    alignas(64) std::size_t consumerHead_ = 0;
+    std::size_t consumerTail_ = 0;
+    std::size_t unreleased_ = 0;
+    bool done_ = false;
+
+    // Last, so that the producer only starts once everything else is set up.
+    std::thread thread_;
+};
@@ -0,0 +1,701 @@
+// Generator workloads closer to production code than those of bench.cpp:
+// tokenizer pipelines, combinatorial enumeration, a prime sieve and a
+// decode/filter/aggregate stream. Each one runs as chained generators and
+// as a plain loop doing the same work, both built on the same scanning
+// and parsing helpers, so that the difference is the cost of the
+// coroutines.
+
+#include <benchmark/benchmark.h>
+#include <generator.hpp>
+#include <fused.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static std::uint64_t next_random(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static std::int64_t parse_int(std::string_view text) {
+    std::int64_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+////////////////////////////////////////////////////////////////
+// CSV: lines -> fields -> one column parsed as integers, summed.
+
+// About 8 MiB of "id,name,price,quantity" rows; some names are quoted
+// and contain a comma.
+static const std::string& csv_text() {
+    static const std::string text = [] {
+        std::string s = "id,name,price,quantity\n";
+        std::uint64_t state = 0x9e3779b97f4a7c15;
+        for (std::uint64_t id = 0; s.size() < (std::size_t(8) << 20); ++id) {
+            const auto r = next_random(state);
+            s += std::to_string(id);
+            s += r % 4 == 0 ? ",\"Doe, J.\"," : ",item-" + std::to_string(r % 1000) + ",";
+            s += std::to_string(r % 100000);
+            s += ',';
+            s += std::to_string(1 + (r >> 20) % 50);
+            s += '\n';
+        }
+        return s;
+    }();
+    return text;
+}
+
+// Removes the first field from `line` and returns it, without its quotes.
+static std::string_view split_field(std::string_view& line) {
+    std::size_t end;
+    std::string_view field;
+    if (!line.empty() && line.front() == '"') {
+        const auto quote = line.find('"', 1);
+        field = line.substr(1, quote - 1);
+        end = line.find(',', quote);
+    } else {
+        end = line.find(',');
+        field = line.substr(0, end);
+    }
+    line = end == line.npos ? std::string_view{} : line.substr(end + 1);
+    return field;
+}
+
+// Removes the first line from `text` and returns it, without its newline.
+static std::string_view split_line(std::string_view& text) {
+    const auto* newline = static_cast<const char*>(std::memchr(text.data(), '\n', text.size()));
+    const std::size_t length = newline ? std::size_t(newline - text.data()) : text.size();
+    const auto line = text.substr(0, length);
+    text.remove_prefix(std::min(text.size(), length + 1));
+    return line;
+}
+
+struct csv_field {
+    std::string_view text;
+    std::size_t column;
+};
+
+static simple::generator<std::string_view> csv_lines(std::string_view text) {
+    while (!text.empty())
+        co_yield split_line(text);
+}
+
+static simple::generator<csv_field> csv_fields(simple::generator<std::string_view> lines) {
+    for (std::string_view line : lines) {
+        for (std::size_t column = 0; !line.empty(); ++column)
+            co_yield csv_field{split_field(line), column};
+    }
+}
+
+static simple::generator<std::int64_t> csv_column(simple::generator<csv_field> fields, std::size_t column) {
+    bool header = true;
+    for (const csv_field& field : fields) {
+        if (field.column != column)
+            continue;
+        if (!std::exchange(header, false))
+            co_yield parse_int(field.text);
+    }
+}
+
+static std::int64_t csv_sum_baseline(std::string_view text, std::size_t column) {
+    std::int64_t sum = 0;
+    bool header = true;
+    while (!text.empty()) {
+        std::string_view line = split_line(text);
+        for (std::size_t i = 0; !line.empty(); ++i) {
+            const auto field = split_field(line);
+            if (i == column && !std::exchange(header, false))
+                sum += parse_int(field);
+        }
+    }
+    return sum;
+}
+
+static void BM_CsvPipeline(benchmark::State& state) {
+  const auto& text = csv_text();
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    for(auto && price : csv_column(csv_fields(csv_lines(text)), 2)) {
+        sum += price;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_CsvBaseline(benchmark::State& state) {
+  const auto& text = csv_text();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(csv_sum_baseline(text, 2));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+////////////////////////////////////////////////////////////////
+// JSON: characters -> tokens -> values of one member, summed.
+
+// About 8 MiB: an array of objects with strings, numbers, a nested array
+// and literals.
+static const std::string& json_text() {
+    static const std::string text = [] {
+        std::string s = "[";
+        std::uint64_t state = 0x2545f4914f6cdd1d;
+        for (std::uint64_t id = 0; s.size() < (std::size_t(8) << 20); ++id) {
+            const auto r = next_random(state);
+            if (id != 0)
+                s += ",\n";
+            s += "{\"id\": " + std::to_string(id) + ", \"name\": \"user " + std::to_string(r % 10000) +
+                 "\", \"tags\": [\"a\", \"b\", " + std::to_string(r % 7) + "], \"active\": " +
+                 (r % 2 ? "true" : "false") + ", \"score\": " + std::to_string(r % 1000) + "}";
+        }
+        s += "]";
+        return s;
+    }();
+    return text;
+}
+
+enum class json_kind : std::uint8_t {
+    begin_object,
+    end_object,
+    begin_array,
+    end_array,
+    colon,
+    comma,
+    string,
+    number,
+    literal,
+};
+
+struct json_token {
+    json_kind kind;
+    // Without the quotes for strings; no escapes are decoded.
+    std::string_view text;
+};
+
+// Reads the token at p, if any, and returns the position after it.
+static const char* lex_json(const char* p, const char* end, json_token& token) {
+    while (p != end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+        ++p;
+    if (p == end)
+        return nullptr;
+    switch (*p) {
+    case '{': token = {json_kind::begin_object, {p, 1}}; return p + 1;
+    case '}': token = {json_kind::end_object, {p, 1}}; return p + 1;
+    case '[': token = {json_kind::begin_array, {p, 1}}; return p + 1;
+    case ']': token = {json_kind::end_array, {p, 1}}; return p + 1;
+    case ':': token = {json_kind::colon, {p, 1}}; return p + 1;
+    case ',': token = {json_kind::comma, {p, 1}}; return p + 1;
+    case '"': {
+        const char* q = p + 1;
+        while (q != end && *q != '"')
+            q += *q == '\\' ? 2 : 1;
+        token = {json_kind::string, {p + 1, std::size_t(q - p - 1)}};
+        return q == end ? end : q + 1;
+    }
+    default: {
+        const char* q = p;
+        while (q != end && !std::strchr(" \n\t\r,:]}", *q))
+            ++q;
+        token = {*p == '-' || (*p >= '0' && *p <= '9') ? json_kind::number : json_kind::literal,
+                 {p, std::size_t(q - p)}};
+        return q;
+    }
+    }
+}
+
+static simple::generator<const json_token&> json_tokens(std::string_view text) {
+    const char* const end = text.data() + text.size();
+    json_token token;
+    for (const char* p = text.data(); (p = lex_json(p, end, token));)
+        co_yield token;
+}
+
+// Values of the members named `key`, at any depth.
+static simple::generator<const json_token&> json_members(simple::generator<const json_token&> tokens,
+                                                         std::string_view key) {
+    // 0: looking for the key, 1: key seen, 2: colon seen.
+    int matched = 0;
+    for (const json_token& token : tokens) {
+        if (matched == 2)
+            co_yield token;
+        if (matched == 1 && token.kind == json_kind::colon)
+            matched = 2;
+        else
+            matched = token.kind == json_kind::string && token.text == key;
+    }
+}
+
+static std::int64_t json_sum_baseline(std::string_view text, std::string_view key) {
+    const char* const end = text.data() + text.size();
+    std::int64_t sum = 0;
+    int matched = 0;
+    json_token token;
+    for (const char* p = text.data(); (p = lex_json(p, end, token));) {
+        if (matched == 2 && token.kind == json_kind::number)
+            sum += parse_int(token.text);
+        if (matched == 1 && token.kind == json_kind::colon)
+            matched = 2;
+        else
+            matched = token.kind == json_kind::string && token.text == key;
+    }
+    return sum;
+}
+
+static void BM_JsonPipeline(benchmark::State& state) {
+  const auto& text = json_text();
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    for(auto && token : json_members(json_tokens(text), "score")) {
+        if (token.kind == json_kind::number)
+            sum += parse_int(token.text);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_JsonBaseline(benchmark::State& state) {
+  const auto& text = json_text();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(json_sum_baseline(text, "score"));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+////////////////////////////////////////////////////////////////
+// Permutations and combinations, yielded in place as spans.
+
+// Heap's algorithm, iteratively.
+static simple::generator<std::span<const int>> permutations(int n) {
+    std::vector<int> a(n), c(n, 0);
+    for (int i = 0; i < n; ++i)
+        a[i] = i;
+    co_yield std::span<const int>(a);
+    for (int i = 1; i < n;) {
+        if (c[i] < i) {
+            std::swap(a[i % 2 == 0 ? 0 : c[i]], a[i]);
+            co_yield std::span<const int>(a);
+            ++c[i];
+            i = 1;
+        } else {
+            c[i++] = 0;
+        }
+    }
+}
+
+// Heap's algorithm, recursively: one generator per level.
+static recursive::generator<std::span<const int>> permutations_nested(std::vector<int>& a, int k) {
+    if (k <= 1) {
+        co_yield std::span<const int>(a);
+        co_return;
+    }
+    for (int i = 0; i < k - 1; ++i) {
+        co_yield elements_of(permutations_nested(a, k - 1));
+        std::swap(a[k % 2 == 0 ? i : 0], a[k - 1]);
+    }
+    co_yield elements_of(permutations_nested(a, k - 1));
+}
+
+template <typename F>
+static void permutations_baseline(int n, F&& f) {
+    std::vector<int> a(n), c(n, 0);
+    for (int i = 0; i < n; ++i)
+        a[i] = i;
+    f(std::span<const int>(a));
+    for (int i = 1; i < n;) {
+        if (c[i] < i) {
+            std::swap(a[i % 2 == 0 ? 0 : c[i]], a[i]);
+            f(std::span<const int>(a));
+            ++c[i];
+            i = 1;
+        } else {
+            c[i++] = 0;
+        }
+    }
+}
+
+// k-combinations of 0..n-1 in lexicographic order.
+static simple::generator<std::span<const int>> combinations(int n, int k) {
+    std::vector<int> a(k);
+    for (int i = 0; i < k; ++i)
+        a[i] = i;
+    for (;;) {
+        co_yield std::span<const int>(a);
+        int i = k - 1;
+        while (i >= 0 && a[i] == n - k + i)
+            --i;
+        if (i < 0)
+            co_return;
+        ++a[i];
+        for (int j = i + 1; j < k; ++j)
+            a[j] = a[j - 1] + 1;
+    }
+}
+
+template <typename F>
+static void combinations_baseline(int n, int k, F&& f) {
+    std::vector<int> a(k);
+    for (int i = 0; i < k; ++i)
+        a[i] = i;
+    for (;;) {
+        f(std::span<const int>(a));
+        int i = k - 1;
+        while (i >= 0 && a[i] == n - k + i)
+            --i;
+        if (i < 0)
+            return;
+        ++a[i];
+        for (int j = i + 1; j < k; ++j)
+            a[j] = a[j - 1] + 1;
+    }
+}
+
+// What consumers of permutations and combinations do with them.
+static std::uint64_t checksum(std::span<const int> s) {
+    return std::uint64_t(s.front()) * 31 + std::uint64_t(s.back());
+}
+
+static void BM_Permutations(benchmark::State& state) {
+  const int n = state.range(0);
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for(auto && p : permutations(n)) {
+        sum += checksum(p);
+        ++count;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+static void BM_PermutationsNested(benchmark::State& state) {
+  const int n = state.range(0);
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::vector<int> a(n);
+    for (int i = 0; i < n; ++i)
+        a[i] = i;
+    std::uint64_t sum = 0;
+    for(auto && p : permutations_nested(a, n)) {
+        sum += checksum(p);
+        ++count;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+static void BM_PermutationsBaseline(benchmark::State& state) {
+  const int n = state.range(0);
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    permutations_baseline(n, [&](std::span<const int> p) {
+        sum += checksum(p);
+        ++count;
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+static void BM_Combinations(benchmark::State& state) {
+  const int n = state.range(0), k = state.range(1);
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for(auto && c : combinations(n, k)) {
+        sum += checksum(c);
+        ++count;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+static void BM_CombinationsBaseline(benchmark::State& state) {
+  const int n = state.range(0), k = state.range(1);
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    combinations_baseline(n, k, [&](std::span<const int> c) {
+        sum += checksum(c);
+        ++count;
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+////////////////////////////////////////////////////////////////
+// Primes below a limit, from a segmented sieve of Eratosthenes.
+
+class segmented_sieve {
+  public:
+    static constexpr std::uint32_t segment_size = 32 * 1024;
+
+    explicit segmented_sieve(std::uint32_t limit) : limit_(limit), composite_(segment_size) {
+        const auto root = std::uint32_t(std::sqrt(double(limit))) + 1;
+        std::vector<bool> small(root + 1, false);
+        for (std::uint32_t p = 2; p <= root; ++p) {
+            if (small[p])
+                continue;
+            primes_.push_back(p);
+            for (std::uint32_t m = p * p; m <= root; m += p)
+                small[m] = true;
+        }
+    }
+
+    // Marks the composites of [low, low + segment_size), and returns the
+    // end of the segment, clipped to the limit.
+    std::uint32_t sieve(std::uint32_t low) {
+        const std::uint32_t high = std::min<std::uint64_t>(std::uint64_t(low) + segment_size, limit_);
+        std::fill(composite_.begin(), composite_.end(), 0);
+        for (const std::uint32_t p : primes_) {
+            const std::uint64_t square = std::uint64_t(p) * p;
+            if (square >= high)
+                break;
+            std::uint64_t m = std::max<std::uint64_t>(square, (std::uint64_t(low) + p - 1) / p * p);
+            for (; m < high; m += p)
+                composite_[m - low] = 1;
+        }
+        return high;
+    }
+
+    bool is_prime(std::uint32_t n, std::uint32_t low) const noexcept {
+        return n >= 2 && !composite_[n - low];
+    }
+
+    std::uint32_t limit() const noexcept {
+        return limit_;
+    }
+
+  private:
+    std::uint32_t limit_;
+    std::vector<std::uint32_t> primes_;
+    std::vector<std::uint8_t> composite_;
+};
+
+static simple::generator<std::uint32_t> primes(std::uint32_t limit) {
+    segmented_sieve sieve(limit);
+    for (std::uint32_t low = 0; low < limit;) {
+        const auto high = sieve.sieve(low);
+        for (std::uint32_t n = low; n < high; ++n) {
+            if (sieve.is_prime(n, low))
+                co_yield n;
+        }
+        low = high;
+    }
+}
+
+template <typename F>
+static void primes_baseline(std::uint32_t limit, F&& f) {
+    segmented_sieve sieve(limit);
+    for (std::uint32_t low = 0; low < limit;) {
+        const auto high = sieve.sieve(low);
+        for (std::uint32_t n = low; n < high; ++n) {
+            if (sieve.is_prime(n, low))
+                f(n);
+        }
+        low = high;
+    }
+}
+
+static void BM_Primes(benchmark::State& state) {
+  const auto limit = std::uint32_t(state.range(0));
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for(auto && p : primes(limit)) {
+        sum += p;
+        ++count;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+static void BM_PrimesBaseline(benchmark::State& state) {
+  const auto limit = std::uint32_t(state.range(0));
+  std::uint64_t count = 0;
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    primes_baseline(limit, [&](std::uint32_t p) {
+        sum += p;
+        ++count;
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(count);
+}
+
+////////////////////////////////////////////////////////////////
+// Decode -> filter -> aggregate over varint-encoded events.
+
+struct event {
+    std::uint64_t time;
+    std::uint32_t user;
+    std::int64_t amount;
+};
+
+static void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(std::uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(std::uint8_t(v));
+}
+
+static std::uint64_t get_varint(const std::uint8_t*& p) {
+    std::uint64_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const std::uint8_t byte = *p++;
+        v |= std::uint64_t(byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return v;
+    }
+}
+
+// About 16 MiB of events: time as a delta from the previous event, then
+// user, then amount zigzag-encoded.
+static const std::vector<std::uint8_t>& event_stream() {
+    static const std::vector<std::uint8_t> bytes = [] {
+        std::vector<std::uint8_t> out;
+        std::uint64_t state = 0x853c49e6748fea9b;
+        while (out.size() < (std::size_t(16) << 20)) {
+            const auto r = next_random(state);
+            const auto amount = std::int64_t(r % 20001) - 10000;
+            put_varint(out, r % 1000);
+            put_varint(out, (r >> 16) % 100000);
+            put_varint(out, (std::uint64_t(amount) << 1) ^ std::uint64_t(amount >> 63));
+        }
+        return out;
+    }();
+    return bytes;
+}
+
+static event decode_event(const std::uint8_t*& p, std::uint64_t& time) {
+    time += get_varint(p);
+    const auto user = std::uint32_t(get_varint(p));
+    const auto zigzag = get_varint(p);
+    return {time, user, std::int64_t(zigzag >> 1) ^ -std::int64_t(zigzag & 1)};
+}
+
+inline constexpr auto is_large_debit = [](const event& e) { return e.amount < -5000 && e.user % 4 != 0; };
+
+struct event_totals {
+    std::uint64_t count = 0;
+    std::int64_t sum = 0;
+    std::int64_t min = 0;
+    std::uint64_t last = 0;
+
+    void operator()(const event& e) {
+        ++count;
+        sum += e.amount;
+        min = std::min(min, e.amount);
+        last = e.time;
+    }
+};
+
+// A decoder fused adaptors can run in.
+using fused_event_generator =
+    simple::generator<const event&, event, std::allocator<std::byte>,
+                      generator_policy<exception_policy::propagate, start_policy::lazy, storage_policy::copy,
+                                       timing_policy::untimed, filter_policy::filtered>>;
+
+template <typename Generator = simple::generator<const event&>>
+static Generator decode_events(std::span<const std::uint8_t> bytes) {
+    const std::uint8_t* p = bytes.data();
+    const std::uint8_t* const end = p + bytes.size();
+    std::uint64_t time = 0;
+    while (p != end) {
+        const event e = decode_event(p, time);
+        co_yield e;
+    }
+}
+
+template <typename P>
+static simple::generator<const event&> filter_events(simple::generator<const event&> events, P pred) {
+    for (const event& e : events) {
+        if (pred(e))
+            co_yield e;
+    }
+}
+
+static event_totals aggregate_baseline(std::span<const std::uint8_t> bytes) {
+    event_totals totals;
+    const std::uint8_t* p = bytes.data();
+    const std::uint8_t* const end = p + bytes.size();
+    std::uint64_t time = 0;
+    while (p != end) {
+        const event e = decode_event(p, time);
+        if (is_large_debit(e))
+            totals(e);
+    }
+    return totals;
+}
+
+static void BM_EventPipeline(benchmark::State& state) {
+  const auto& bytes = event_stream();
+  for (auto _ : state) {
+    event_totals totals;
+    for(auto && e : filter_events(decode_events(bytes), is_large_debit)) {
+        totals(e);
+    }
+    benchmark::DoNotOptimize(totals);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// The filter fused into the decoder with fused::filter.
+static void BM_EventPipelineFused(benchmark::State& state) {
+  const auto& bytes = event_stream();
+  for (auto _ : state) {
+    event_totals totals;
+    for(auto && e : decode_events<fused_event_generator>(bytes) | fused::filter(is_large_debit)) {
+        totals(e);
+    }
+    benchmark::DoNotOptimize(totals);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+static void BM_EventBaseline(benchmark::State& state) {
+  const auto& bytes = event_stream();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(aggregate_baseline(bytes));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(BM_CsvPipeline)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CsvBaseline)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonPipeline)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonBaseline)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_Permutations)->DenseRange(8, 10, 1);
+BENCHMARK(BM_PermutationsNested)->DenseRange(8, 10, 1);
+BENCHMARK(BM_PermutationsBaseline)->DenseRange(8, 10, 1);
+BENCHMARK(BM_Combinations)->ArgNames({"n", "k"})->Args({24, 4})->Args({24, 12});
+BENCHMARK(BM_CombinationsBaseline)->ArgNames({"n", "k"})->Args({24, 4})->Args({24, 12});
+
+BENCHMARK(BM_Primes)->RangeMultiplier(100)->Range(10000, 100000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PrimesBaseline)->RangeMultiplier(100)->Range(10000, 100000000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_EventPipeline)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EventPipelineFused)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EventBaseline)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();